@@ -0,0 +1,127 @@
+#ifndef ADAFRUIT_BMP280_H_
+#define ADAFRUIT_BMP280_H_
+
+#include <math.h>
+
+#include <Wire.h>
+
+#include "Adafruit_Sensor.h"
+#include "sim.h"
+
+#define BMP280_ADDRESS     (0x77)
+#define BMP280_CHIPID      (0x58)
+
+// Simulated BMP280 reporting a standard atmosphere at sea level, drifting
+// slowly over the simulated day. Register accesses go over the simulated I2C
+// bus and a forced measurement takes its datasheet conversion time.
+class Adafruit_BMP280 {
+public:
+  enum sensor_sampling {
+    SAMPLING_NONE = 0x00,
+    SAMPLING_X1   = 0x01,
+    SAMPLING_X2   = 0x02,
+    SAMPLING_X4   = 0x03,
+    SAMPLING_X8   = 0x04,
+    SAMPLING_X16  = 0x05
+  };
+
+  enum sensor_mode {
+    MODE_SLEEP  = 0x00,
+    MODE_FORCED = 0x01,
+    MODE_NORMAL = 0x03,
+    MODE_SOFT_RESET_CODE = 0xB6
+  };
+
+  enum sensor_filter {
+    FILTER_OFF = 0x00,
+    FILTER_X2  = 0x01,
+    FILTER_X4  = 0x02,
+    FILTER_X8  = 0x03,
+    FILTER_X16 = 0x04
+  };
+
+  enum standby_duration {
+    STANDBY_MS_1    = 0x00,
+    STANDBY_MS_63   = 0x01,
+    STANDBY_MS_125  = 0x02,
+    STANDBY_MS_250  = 0x03,
+    STANDBY_MS_500  = 0x04,
+    STANDBY_MS_1000 = 0x05,
+    STANDBY_MS_2000 = 0x06,
+    STANDBY_MS_4000 = 0x07
+  };
+
+  explicit Adafruit_BMP280(TwoWire *theWire = &Wire) : mWire(theWire), mAddress(BMP280_ADDRESS), mMode(MODE_NORMAL), mTemperatureSampling(SAMPLING_X16), mPressureSampling(SAMPLING_X16) {
+  }
+
+  bool begin(uint8_t addr = BMP280_ADDRESS, uint8_t chipid = BMP280_CHIPID) {
+    (void)chipid;
+    mAddress = addr;
+    // chip id, then the 24 calibration bytes
+    readRegisters(0xD0, 1);
+    readRegisters(0x88, 24);
+    setSampling();
+    return true;
+  }
+  void setSampling(sensor_mode mode = MODE_NORMAL, sensor_sampling tempSampling = SAMPLING_X16, sensor_sampling pressSampling = SAMPLING_X16, sensor_filter filter = FILTER_OFF, standby_duration duration = STANDBY_MS_1) {
+    (void)filter;
+    (void)duration;
+    mMode                = mode;
+    mTemperatureSampling = tempSampling;
+    mPressureSampling    = pressSampling;
+    writeRegister(0xF5);
+    writeRegister(0xF4);
+  }
+  bool takeForcedMeasurement() {
+    if (mMode != MODE_FORCED) {
+      return false;
+    }
+    writeRegister(0xF4);
+    sim::advance_us(measureTime_us());
+    readRegisters(0xF3, 1);
+    return true;
+  }
+  float readTemperature() {
+    readRegisters(0xFA, 3);
+    return 15.0f + 5.0f * sinf(dayAngle());
+  }
+  float readPressure() {
+    // the temperature again for the compensation
+    readRegisters(0xFA, 3);
+    readRegisters(0xF7, 3);
+    return 101325.0f + 800.0f * sinf(dayAngle() / 3);
+  }
+
+private:
+  // typical conversion time from the datasheet, 2.3 ms for each oversampled
+  // measurement
+  uint32_t measureTime_us() const {
+    return 1250 + oversampling(mTemperatureSampling) * 2300 + (mPressureSampling ? oversampling(mPressureSampling) * 2300 + 575 : 0);
+  }
+  static uint32_t oversampling(sensor_sampling sampling) {
+    return sampling ? 1U << (sampling - 1) : 0;
+  }
+  static float dayAngle() {
+    return (float)(sim::now_us() % 86400000000ULL) / 86400000000.0f * 2 * (float)M_PI;
+  }
+  void writeRegister(uint8_t reg) {
+    mWire->beginTransmission(mAddress);
+    mWire->write(reg);
+    mWire->write((uint8_t)0);
+    mWire->endTransmission();
+  }
+  void readRegisters(uint8_t reg, uint8_t count) {
+    mWire->beginTransmission(mAddress);
+    mWire->write(reg);
+    mWire->endTransmission();
+    mWire->requestFrom(mAddress, count);
+  }
+
+  TwoWire        *mWire;
+  uint8_t         mAddress;
+  sensor_mode     mMode;
+  sensor_sampling mTemperatureSampling;
+  sensor_sampling mPressureSampling;
+};
+
+#endif
@@ -0,0 +1,11 @@
+#include "Adafruit_GFX.h"
+
+size_t Adafruit_GFX::write(uint8_t c) {
+  if (c == '\n') {
+    cursor_x = 0;
+    cursor_y += textsize * 8;
+  } else if (c != '\r') {
+    cursor_x += textsize * 6;
+  }
+  return 1;
+}
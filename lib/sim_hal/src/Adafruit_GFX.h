@@ -0,0 +1,48 @@
+#ifndef ADAFRUIT_GFX_H_
+#define ADAFRUIT_GFX_H_
+
+#include <Arduino.h>
+
+// Text-only canvas: glyphs are not rasterized, the simulation only needs to
+// know that pixels changed.
+class Adafruit_GFX : public Print {
+public:
+  Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h), cursor_x(0), cursor_y(0), textsize(1), textcolor(1) {
+  }
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  void setCursor(int16_t x, int16_t y) {
+    cursor_x = x;
+    cursor_y = y;
+  }
+  void setTextSize(uint8_t s) {
+    textsize = s;
+  }
+  void setTextColor(uint16_t c) {
+    textcolor = c;
+  }
+  int16_t getCursorX() const {
+    return cursor_x;
+  }
+  int16_t getCursorY() const {
+    return cursor_y;
+  }
+  int16_t width() const {
+    return WIDTH;
+  }
+  int16_t height() const {
+    return HEIGHT;
+  }
+
+protected:
+  const int16_t WIDTH;
+  const int16_t HEIGHT;
+  int16_t       cursor_x;
+  int16_t       cursor_y;
+  uint8_t       textsize;
+  uint16_t      textcolor;
+};
+
+#endif
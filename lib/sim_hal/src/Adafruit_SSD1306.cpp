@@ -0,0 +1,73 @@
+#include "Adafruit_SSD1306.h"
+#include "sim.h"
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire *twi, int8_t rst_pin) : Adafruit_GFX(w, h), wire(twi), i2caddr(0) {
+  (void)rst_pin;
+  memset(buffer, 0, sizeof(buffer));
+}
+
+bool Adafruit_SSD1306::begin(uint8_t switchvcc, uint8_t addr, bool reset, bool periphBegin) {
+  (void)switchvcc;
+  (void)reset;
+  (void)periphBegin;
+  i2caddr = addr ? addr : 0x3C;
+  // init sequence of the library is 25 commands
+  for (int i = 0; i < 25; i++) {
+    ssd1306_command(0);
+  }
+  ssd1306_command(SSD1306_DISPLAYON);
+  return true;
+}
+
+void Adafruit_SSD1306::display() {
+  wire->setClock(400000);
+  ssd1306_command(SSD1306_PAGEADDR);
+  ssd1306_command(0);
+  ssd1306_command(0xFF);
+  ssd1306_command(SSD1306_COLUMNADDR);
+  ssd1306_command(0);
+  ssd1306_command(WIDTH - 1);
+  const uint8_t *ptr   = buffer;
+  size_t         count = sizeof(buffer);
+  while (count) {
+    size_t chunk = count > 31 ? 31 : count;
+    wire->beginTransmission(i2caddr);
+    wire->write((uint8_t)0x40);
+    wire->write(ptr, chunk);
+    wire->endTransmission();
+    ptr += chunk;
+    count -= chunk;
+  }
+  wire->setClock(100000);
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+  memset(buffer, 0, sizeof(buffer));
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
+  wire->beginTransmission(i2caddr);
+  wire->write((uint8_t)0x00);
+  wire->write(c);
+  wire->endTransmission();
+  // every push of framebuffer data starts with its window
+  if (c == SSD1306_PAGEADDR) {
+    sim::stats().display_flushes++;
+  } else if (c == SSD1306_DISPLAYON) {
+    sim::set_load(sim::LoadOled, sim::OledOn_mA);
+  } else if (c == SSD1306_DISPLAYOFF) {
+    sim::set_load(sim::LoadOled, 0.0f);
+  }
+}
+
+uint8_t *Adafruit_SSD1306::getBuffer() {
+  return buffer;
+}
+
+size_t Adafruit_SSD1306::write(uint8_t c) {
+  // mark the cell as drawn so the framebuffer changes like on the panel
+  if (c != '\n' && c != '\r' && cursor_x >= 0 && cursor_x < WIDTH && cursor_y >= 0 && cursor_y < HEIGHT) {
+    buffer[(cursor_y / 8) * WIDTH + cursor_x] ^= c;
+  }
+  return Adafruit_GFX::write(c);
+}
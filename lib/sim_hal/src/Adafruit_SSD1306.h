@@ -0,0 +1,42 @@
+#ifndef ADAFRUIT_SSD1306_H_
+#define ADAFRUIT_SSD1306_H_
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+#define BLACK   0
+#define WHITE   1
+#define INVERSE 2
+
+#define SSD1306_EXTERNALVCC  0x01
+#define SSD1306_SWITCHCAPVCC 0x02
+
+#define SSD1306_MEMORYMODE   0x20
+#define SSD1306_COLUMNADDR   0x21
+#define SSD1306_PAGEADDR     0x22
+#define SSD1306_SETCONTRAST  0x81
+#define SSD1306_DISPLAYOFF   0xAE
+#define SSD1306_DISPLAYON    0xAF
+
+// SSD1306 stand-in: commands and framebuffer pushes go over the simulated I2C
+// bus, DISPLAYON/DISPLAYOFF switch the panel load.
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+  Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire *twi = &Wire, int8_t rst_pin = -1);
+
+  bool     begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = 0, bool reset = true, bool periphBegin = true);
+  void     display();
+  void     clearDisplay();
+  void     ssd1306_command(uint8_t c);
+  uint8_t *getBuffer();
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+private:
+  TwoWire *wire;
+  uint8_t  i2caddr;
+  uint8_t  buffer[128 * 64 / 8];
+};
+
+#endif
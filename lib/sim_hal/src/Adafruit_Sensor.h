@@ -0,0 +1,6 @@
+#ifndef ADAFRUIT_SENSOR_H_
+#define ADAFRUIT_SENSOR_H_
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool    boolean;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT             0x01
+#define OUTPUT            0x03
+#define PULLUP            0x04
+#define INPUT_PULLUP      0x05
+#define OPEN_DRAIN        0x10
+#define OUTPUT_OPEN_DRAIN 0x12
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PI         3.1415926535897932384626433832795
+#define HALF_PI    1.5707963267948966192313216916398
+#define TWO_PI     6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define radians(deg) ((deg)*DEG_TO_RAD)
+#define degrees(rad) ((rad)*RAD_TO_DEG)
+#define sq(x)        ((x) * (x))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// TTGO T-Beam board variant (pins_arduino.h)
+static const uint8_t SDA       = 21;
+static const uint8_t SCL       = 22;
+static const uint8_t LORA_SCK  = 5;
+static const uint8_t LORA_MISO = 19;
+static const uint8_t LORA_MOSI = 27;
+static const uint8_t LORA_CS   = 18;
+static const uint8_t LORA_RST  = 23;
+static const uint8_t LORA_IRQ  = 26;
+
+typedef enum {
+  GPIO_NUM_4  = 4,
+  GPIO_NUM_38 = 38,
+} gpio_num_t;
+
+typedef enum {
+  GPIO_INTR_DISABLE    = 0,
+  GPIO_INTR_LOW_LEVEL  = 4,
+  GPIO_INTR_HIGH_LEVEL = 5,
+} gpio_int_type_t;
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+// RTC slow memory is carried over the reboot that ends a simulated deep sleep
+#define RTC_DATA_ATTR __attribute__((section("sim_retained")))
+
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED,
+  ESP_SLEEP_WAKEUP_ALL,
+  ESP_SLEEP_WAKEUP_EXT0,
+  ESP_SLEEP_WAKEUP_EXT1,
+  ESP_SLEEP_WAKEUP_TIMER,
+  ESP_SLEEP_WAKEUP_TOUCHPAD,
+  ESP_SLEEP_WAKEUP_ULP,
+  ESP_SLEEP_WAKEUP_GPIO,
+  ESP_SLEEP_WAKEUP_UART,
+} esp_sleep_wakeup_cause_t;
+
+unsigned long millis();
+unsigned long micros();
+void          delay(uint32_t ms);
+void          delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+bool     btStop();
+bool     setCpuFrequencyMhz(uint32_t cpu_freq_mhz);
+uint32_t getCpuFrequencyMhz();
+
+esp_err_t                gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type);
+esp_err_t                esp_sleep_enable_gpio_wakeup();
+esp_err_t                esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t                esp_light_sleep_start();
+esp_err_t                esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level);
+void                     esp_deep_sleep_start() __attribute__((noreturn));
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+
+#include "HardwareSerial.h"
+#include "WString.h"
+
+#endif
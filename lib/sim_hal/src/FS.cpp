@@ -0,0 +1,106 @@
+#include <sys/stat.h>
+
+#include "FS.h"
+#include "sim.h"
+
+namespace fs {
+
+static void closeHandle(FILE *handle) {
+  if (handle) {
+    fclose(handle);
+  }
+}
+
+File::File(FILE *handle) : mHandle(handle, closeHandle) {
+}
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buf, size_t size) {
+  return mHandle ? fwrite(buf, 1, size, mHandle.get()) : 0;
+}
+
+int File::available() {
+  if (!mHandle) {
+    return 0;
+  }
+  return (int)(size() - position());
+}
+
+int File::read() {
+  return mHandle ? fgetc(mHandle.get()) : -1;
+}
+
+int File::peek() {
+  if (!mHandle) {
+    return -1;
+  }
+  int c = fgetc(mHandle.get());
+  if (c != EOF) {
+    ungetc(c, mHandle.get());
+  }
+  return c;
+}
+
+void File::flush() {
+  if (mHandle) {
+    fflush(mHandle.get());
+  }
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+  return mHandle ? fread(buf, 1, size, mHandle.get()) : 0;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  return mHandle && fseek(mHandle.get(), pos, mode) == 0;
+}
+
+size_t File::position() const {
+  return mHandle ? ftell(mHandle.get()) : 0;
+}
+
+size_t File::size() const {
+  if (!mHandle) {
+    return 0;
+  }
+  struct stat st;
+  fflush(mHandle.get());
+  if (fstat(fileno(mHandle.get()), &st) != 0) {
+    return 0;
+  }
+  return st.st_size;
+}
+
+void File::close() {
+  mHandle.reset();
+}
+
+String FS::hostPath(const char *path) const {
+  return String(sim::options().fs_dir) + path;
+}
+
+File FS::open(const char *path, const char *mode) {
+  String host = hostPath(path);
+  if (mode[0] == 'r') {
+    return File(fopen(host.c_str(), "rb"));
+  }
+  return File(fopen(host.c_str(), mode[0] == 'a' ? "ab+" : "wb+"));
+}
+
+bool FS::exists(const char *path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char *path) {
+  return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char *pathFrom, const char *pathTo) {
+  return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+}
+
+} // namespace fs
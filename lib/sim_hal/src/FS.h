@@ -0,0 +1,80 @@
+#ifndef FS_H_
+#define FS_H_
+
+#include <memory>
+#include <stdio.h>
+
+#include "Stream.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+  SeekSet = 0,
+  SeekCur = 1,
+  SeekEnd = 2
+};
+
+// File of the simulated flash filesystem, backed by a host file.
+class File : public Stream {
+public:
+  File() {
+  }
+  explicit File(FILE *handle);
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  int    available() override;
+  int    read() override;
+  int    peek() override;
+  void   flush() override;
+  size_t read(uint8_t *buf, size_t size);
+  bool   seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void   close();
+
+  using Print::write;
+
+  operator bool() const {
+    return mHandle != nullptr;
+  }
+
+private:
+  std::shared_ptr<FILE> mHandle;
+};
+
+class FS {
+public:
+  explicit FS(const char *name) : mName(name) {
+  }
+
+  File open(const char *path, const char *mode = FILE_READ);
+  File open(const String &path, const char *mode = FILE_READ) {
+    return open(path.c_str(), mode);
+  }
+  bool exists(const char *path);
+  bool exists(const String &path) {
+    return exists(path.c_str());
+  }
+  bool remove(const char *path);
+  bool remove(const String &path) {
+    return remove(path.c_str());
+  }
+  bool rename(const char *pathFrom, const char *pathTo);
+
+protected:
+  String hostPath(const char *path) const;
+
+  const char *mName;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif
@@ -0,0 +1,73 @@
+#include <stdio.h>
+
+#include "HardwareSerial.h"
+#include "sim.h"
+
+HardwareSerial Serial(0);
+
+HardwareSerial::HardwareSerial(int uart_nr) : mUartNr(uart_nr), mBaud(0) {
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin) {
+  (void)config;
+  (void)rxPin;
+  (void)txPin;
+  updateBaudRate(baud);
+}
+
+void HardwareSerial::end() {
+  updateBaudRate(0);
+}
+
+void HardwareSerial::updateBaudRate(unsigned long baud) {
+  mBaud = baud;
+  if (mUartNr == 1) {
+    sim::gps_uart_baud(baud);
+  }
+}
+
+// the simulated receiver is read straight from its recording
+size_t HardwareSerial::setRxBufferSize(size_t size) {
+  return size;
+}
+
+int HardwareSerial::available() {
+  if (mUartNr == 1) {
+    return sim::gps_available();
+  }
+  return sim::console_available();
+}
+
+int HardwareSerial::read() {
+  if (mUartNr == 1) {
+    return sim::gps_read();
+  }
+  return sim::console_read();
+}
+
+int HardwareSerial::peek() {
+  return -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  if (mUartNr == 1) {
+    // the driver blocks once its FIFO is full, 10 bits per byte
+    if (mBaud) {
+      sim::advance_us((uint64_t)size * 10000000 / mBaud);
+    }
+    sim::gps_write(buffer, size);
+  } else {
+    fwrite(buffer, 1, size, stdout);
+  }
+  return size;
+}
+
+void HardwareSerial::flush() {
+  if (mUartNr != 1) {
+    fflush(stdout);
+  }
+}
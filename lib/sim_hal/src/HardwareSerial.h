@@ -0,0 +1,39 @@
+#ifndef HARDWARESERIAL_H_
+#define HARDWARESERIAL_H_
+
+#include "Stream.h"
+
+#define SERIAL_8N1 0x800001c
+
+// UART 0 is the console on stdout fed by --console, UART 1 is wired to the
+// simulated GPS.
+class HardwareSerial : public Stream {
+public:
+  explicit HardwareSerial(int uart_nr);
+
+  void   begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+  void   end();
+  void   updateBaudRate(unsigned long baud);
+  size_t setRxBufferSize(size_t size);
+
+  int    available() override;
+  int    read() override;
+  int    peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  void   flush() override;
+
+  using Print::write;
+
+  operator bool() const {
+    return true;
+  }
+
+private:
+  int           mUartNr;
+  unsigned long mBaud;
+};
+
+extern HardwareSerial Serial;
+
+#endif
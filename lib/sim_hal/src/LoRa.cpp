@@ -0,0 +1,241 @@
+#include <math.h>
+
+#include "LoRa.h"
+#include "sim.h"
+
+LoRaClass LoRa;
+
+LoRaClass::LoRaClass() : mFrequency(0), mTxPower(17), mSpreadingFactor(7), mSignalBandwidth(125000), mCodingRate4(5), mPreambleLength(8), mCrc(false), mImplicitHeader(false), mPacketLength(0) {
+}
+
+int LoRaClass::begin(long frequency) {
+  mFrequency = frequency;
+  idle();
+  return 1;
+}
+
+void LoRaClass::end() {
+  sleep();
+}
+
+int LoRaClass::beginPacket(int implicitHeader) {
+  idle();
+  mImplicitHeader = implicitHeader;
+  mPacketLength   = 0;
+  return 1;
+}
+
+int LoRaClass::endPacket(bool async) {
+  (void)async;
+  uint64_t toa       = timeOnAir_us(mPacketLength);
+  bool     collision = sim::channel_busy(sim::now_us(), sim::now_us() + toa);
+  // PA current roughly scales with output power, 120 mA at +20 dBm
+  sim::set_load(sim::LoadLoRa, sim::LoRaTx20dBm_mA * pow(10.0, (mTxPower - 20) / 20.0));
+  sim::advance_us(toa);
+  sim::set_load(sim::LoadLoRa, sim::LoRaIdle_mA);
+  sim::Stats &stats = sim::stats();
+  stats.tx_us += toa;
+  stats.frames++;
+  stats.tx_bytes += mPacketLength;
+  if (collision) {
+    stats.collisions++;
+  }
+  if (sim::options().verbose) {
+    char text[sizeof(mPacket) * 4 + 1];
+    char *p = text;
+    for (size_t i = 0; i < mPacketLength; i++) {
+      if (mPacket[i] >= 0x20 && mPacket[i] < 0x7f) {
+        *p++ = mPacket[i];
+      } else {
+        p += sprintf(p, "\\x%02X", mPacket[i]);
+      }
+    }
+    *p = 0;
+    sim::log("TX %u bytes, %.0f ms%s: %s", (unsigned)mPacketLength, toa / 1000.0, collision ? ", collides" : "", text);
+  }
+  return 1;
+}
+
+int LoRaClass::parsePacket(int size) {
+  (void)size;
+  return 0;
+}
+
+int LoRaClass::packetRssi() {
+  return -157;
+}
+
+size_t LoRaClass::write(uint8_t byte) {
+  return write(&byte, 1);
+}
+
+size_t LoRaClass::write(const uint8_t *buffer, size_t size) {
+  if (mPacketLength + size > sizeof(mPacket)) {
+    size = sizeof(mPacket) - mPacketLength;
+  }
+  memcpy(mPacket + mPacketLength, buffer, size);
+  mPacketLength += size;
+  return size;
+}
+
+int LoRaClass::available() {
+  return 0;
+}
+
+int LoRaClass::read() {
+  return -1;
+}
+
+int LoRaClass::peek() {
+  return -1;
+}
+
+void LoRaClass::flush() {
+}
+
+void LoRaClass::idle() {
+  sim::set_load(sim::LoadLoRa, sim::LoRaIdle_mA);
+}
+
+void LoRaClass::sleep() {
+  sim::set_load(sim::LoadLoRa, 0.0f);
+}
+
+void LoRaClass::setTxPower(int level, int outputPin) {
+  (void)outputPin;
+  mTxPower = level;
+}
+
+void LoRaClass::setFrequency(long frequency) {
+  mFrequency = frequency;
+}
+
+void LoRaClass::setSpreadingFactor(int sf) {
+  mSpreadingFactor = sf < 6 ? 6 : (sf > 12 ? 12 : sf);
+}
+
+void LoRaClass::setSignalBandwidth(long sbw) {
+  mSignalBandwidth = sbw;
+}
+
+void LoRaClass::setCodingRate4(int denominator) {
+  mCodingRate4 = denominator < 5 ? 5 : (denominator > 8 ? 8 : denominator);
+}
+
+void LoRaClass::setPreambleLength(long length) {
+  mPreambleLength = length;
+}
+
+void LoRaClass::setSyncWord(int sw) {
+  (void)sw;
+}
+
+void LoRaClass::enableCrc() {
+  mCrc = true;
+}
+
+void LoRaClass::disableCrc() {
+  mCrc = false;
+}
+
+void LoRaClass::setPins(int ss, int reset, int dio0) {
+  (void)ss;
+  (void)reset;
+  (void)dio0;
+}
+
+void LoRaClass::setSPI(SPIClass &spi) {
+  (void)spi;
+}
+
+void LoRaClass::setSPIFrequency(uint32_t frequency) {
+  (void)frequency;
+}
+
+uint64_t LoRaClass::symbol_us() const {
+  return (1000000ULL << mSpreadingFactor) / mSignalBandwidth;
+}
+
+// SX1276/77/78 datasheet, section 4.1.1.7, with low data rate optimization
+// decided like the library does in setLdoFlag().
+uint64_t LoRaClass::timeOnAir_us(size_t length) const {
+  long   symbolDuration = 1000 / (mSignalBandwidth / (1L << mSpreadingFactor));
+  int    lowDr          = symbolDuration > 16 ? 1 : 0;
+  double tSym           = (double)(1L << mSpreadingFactor) / mSignalBandwidth;
+  double tPreamble      = (mPreambleLength + 4.25) * tSym;
+  double num            = 8.0 * length - 4.0 * mSpreadingFactor + 28 + (mCrc ? 16 : 0) - (mImplicitHeader ? 20 : 0);
+  double nPayload       = 8 + max(ceil(num / (4.0 * (mSpreadingFactor - 2 * lowDr))) * mCodingRate4, 0.0);
+  return (uint64_t)((tPreamble + nPayload * tSym) * 1e6);
+}
+
+namespace sim {
+
+#define REG_OP_MODE           0x01
+#define REG_IRQ_FLAGS         0x12
+#define MODE_STDBY            0x01
+#define MODE_CAD              0x07
+#define IRQ_CAD_DONE_MASK     0x04
+#define IRQ_CAD_DETECTED_MASK 0x01
+
+// SPI access: the first byte of a selection is the address, write bit 0x80,
+// the next the value.
+static bool     gSelected;
+static int      gSpiIndex;
+static uint8_t  gSpiAddress;
+static uint8_t  gOpMode = 0x80 | MODE_STDBY;
+static uint8_t  gIrqFlags;
+static bool     gCad;
+static bool     gCadDetected;
+static uint64_t gCadEnd_us;
+
+// the radio goes back to standby by itself at the end of a CAD
+static void cadUpdate() {
+  if (gCad && now_us() >= gCadEnd_us) {
+    gCad = false;
+    gIrqFlags |= IRQ_CAD_DONE_MASK | (gCadDetected ? IRQ_CAD_DETECTED_MASK : 0);
+    gOpMode = (gOpMode & ~0x07) | MODE_STDBY;
+    set_load(LoadLoRa, LoRaIdle_mA);
+  }
+}
+
+void sx127x_select(bool selected) {
+  gSelected = selected;
+  gSpiIndex = 0;
+}
+
+uint8_t sx127x_transfer(uint8_t data) {
+  if (!gSelected) {
+    return 0;
+  }
+  if (gSpiIndex++ == 0) {
+    gSpiAddress = data;
+    return 0;
+  }
+  bool    write = gSpiAddress & 0x80;
+  uint8_t reg   = gSpiAddress & 0x7f;
+  cadUpdate();
+  if (reg == REG_OP_MODE) {
+    if (write) {
+      gOpMode = data;
+      gCad    = (data & 0x07) == MODE_CAD;
+      if (gCad) {
+        gCadEnd_us   = now_us() + 2 * LoRa.symbol_us();
+        gCadDetected = channel_busy(now_us(), gCadEnd_us);
+        set_load(LoadLoRa, LoRaRx_mA);
+        stats().cads++;
+      } else {
+        set_load(LoadLoRa, (data & 0x07) == 0 ? 0.0f : LoRaIdle_mA);
+      }
+    }
+    return gOpMode;
+  }
+  if (reg == REG_IRQ_FLAGS) {
+    if (write) {
+      gIrqFlags &= ~data;
+    }
+    return gIrqFlags;
+  }
+  return 0;
+}
+
+} // namespace sim
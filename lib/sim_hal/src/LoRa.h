@@ -0,0 +1,73 @@
+#ifndef LORA_H_
+#define LORA_H_
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include "sim.h"
+
+#define PA_OUTPUT_RFO_PIN      0
+#define PA_OUTPUT_PA_BOOST_PIN 1
+
+// SX1278 stand-in: transmissions take their time-on-air on the simulated
+// clock and are accounted in the simulation statistics. A CAD started over
+// SPI (sim::sx127x_transfer) lasts two symbols of the current settings.
+class LoRaClass : public Stream {
+public:
+  LoRaClass();
+
+  int  begin(long frequency);
+  void end();
+
+  int beginPacket(int implicitHeader = false);
+  int endPacket(bool async = false);
+  int parsePacket(int size = 0);
+  int packetRssi();
+
+  size_t write(uint8_t byte) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int    available() override;
+  int    read() override;
+  int    peek() override;
+  void   flush() override;
+
+  using Print::write;
+
+  void idle();
+  void sleep();
+
+  void setTxPower(int level, int outputPin = PA_OUTPUT_PA_BOOST_PIN);
+  void setFrequency(long frequency);
+  void setSpreadingFactor(int sf);
+  void setSignalBandwidth(long sbw);
+  void setCodingRate4(int denominator);
+  void setPreambleLength(long length);
+  void setSyncWord(int sw);
+  void enableCrc();
+  void disableCrc();
+
+  void setPins(int ss = LORA_CS, int reset = LORA_RST, int dio0 = LORA_IRQ);
+  void setSPI(SPIClass &spi);
+  void setSPIFrequency(uint32_t frequency);
+
+private:
+  friend uint8_t sim::sx127x_transfer(uint8_t data);
+
+  uint64_t timeOnAir_us(size_t length) const;
+  uint64_t symbol_us() const;
+
+  long    mFrequency;
+  int     mTxPower;
+  int     mSpreadingFactor;
+  long    mSignalBandwidth;
+  int     mCodingRate4;
+  long    mPreambleLength;
+  bool    mCrc;
+  bool    mImplicitHeader;
+  uint8_t mPacket[256];
+  size_t  mPacketLength;
+};
+
+extern LoRaClass LoRa;
+
+#endif
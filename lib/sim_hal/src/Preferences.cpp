@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "Preferences.h"
+#include "sim.h"
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition_label) {
+  (void)partition_label;
+  mName     = name;
+  mReadOnly = readOnly;
+  mOpen     = true;
+  return true;
+}
+
+void Preferences::end() {
+  mOpen = false;
+}
+
+String Preferences::keyPath(const char *key) const {
+  return String(sim::options().fs_dir) + "/nvs." + mName + "." + key;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  struct stat st;
+  if (!mOpen || stat(keyPath(key).c_str(), &st) != 0) {
+    return 0;
+  }
+  return st.st_size;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+  size_t length = getBytesLength(key);
+  if (length == 0 || length > maxLen) {
+    return 0;
+  }
+  FILE *file = fopen(keyPath(key).c_str(), "rb");
+  if (!file) {
+    return 0;
+  }
+  length = fread(buf, 1, length, file);
+  fclose(file);
+  return length;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+  if (!mOpen || mReadOnly) {
+    return 0;
+  }
+  FILE *file = fopen(keyPath(key).c_str(), "wb");
+  if (!file) {
+    return 0;
+  }
+  len = fwrite(value, 1, len, file);
+  fclose(file);
+  return len;
+}
+
+bool Preferences::remove(const char *key) {
+  return mOpen && !mReadOnly && ::remove(keyPath(key).c_str()) == 0;
+}
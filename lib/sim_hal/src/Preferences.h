@@ -0,0 +1,30 @@
+#ifndef PREFERENCES_H_
+#define PREFERENCES_H_
+
+#include <stddef.h>
+
+#include "WString.h"
+
+// NVS namespace of the ESP32, each key is a file nvs.<namespace>.<key> in the
+// --fs directory. Only the blob accessors are there.
+class Preferences {
+public:
+  Preferences() : mOpen(false), mReadOnly(false) {
+  }
+
+  bool   begin(const char *name, bool readOnly = false, const char *partition_label = NULL);
+  void   end();
+  size_t getBytesLength(const char *key);
+  size_t getBytes(const char *key, void *buf, size_t maxLen);
+  size_t putBytes(const char *key, const void *value, size_t len);
+  bool   remove(const char *key);
+
+private:
+  String keyPath(const char *key) const;
+
+  String mName;
+  bool   mOpen;
+  bool   mReadOnly;
+};
+
+#endif
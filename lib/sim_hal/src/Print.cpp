@@ -0,0 +1,65 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Print.h"
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::write(const char *str) {
+  return str ? write((const uint8_t *)str, strlen(str)) : 0;
+}
+
+size_t Print::print(const String &str) {
+  return write(str.c_str(), str.length());
+}
+
+size_t Print::print(const char *str) {
+  return write(str);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(int value, int base) {
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(long value, int base) {
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(double value, int digits) {
+  return print(String(value, (unsigned char)digits));
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+size_t Print::printf(const char *format, ...) {
+  char    buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) {
+    return 0;
+  }
+  return write((const uint8_t *)buf, (size_t)len < sizeof(buf) ? len : sizeof(buf) - 1);
+}
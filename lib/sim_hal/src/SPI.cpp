@@ -0,0 +1,26 @@
+#include "SPI.h"
+#include "sim.h"
+
+SPIClass SPI;
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss) {
+  (void)sck;
+  (void)miso;
+  (void)mosi;
+  (void)ss;
+}
+
+void SPIClass::end() {
+}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+  (void)settings;
+}
+
+void SPIClass::endTransaction() {
+}
+
+// the SX1278 is the only device on the bus
+uint8_t SPIClass::transfer(uint8_t data) {
+  return sim::sx127x_transfer(data);
+}
@@ -0,0 +1,29 @@
+#ifndef SPI_H_
+#define SPI_H_
+
+#include <stdint.h>
+
+#define SPI_MODE0 0x00
+#define MSBFIRST  1
+
+class SPISettings {
+public:
+  SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0) : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {
+  }
+  uint32_t clock;
+  uint8_t  bitOrder;
+  uint8_t  dataMode;
+};
+
+class SPIClass {
+public:
+  void    begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+  void    end();
+  void    beginTransaction(SPISettings settings);
+  void    endTransaction();
+  uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+#endif
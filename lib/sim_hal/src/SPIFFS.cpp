@@ -0,0 +1,22 @@
+#include "SPIFFS.h"
+
+fs::SPIFFSFS SPIFFS;
+
+namespace fs {
+
+bool SPIFFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *partitionLabel) {
+  (void)formatOnFail;
+  (void)basePath;
+  (void)maxOpenFiles;
+  (void)partitionLabel;
+  return true;
+}
+
+bool SPIFFSFS::format() {
+  return true;
+}
+
+void SPIFFSFS::end() {
+}
+
+} // namespace fs
@@ -0,0 +1,22 @@
+#ifndef SPIFFS_H_
+#define SPIFFS_H_
+
+#include "FS.h"
+
+namespace fs {
+
+// The SPIFFS partition is the directory given with --fs on the host.
+class SPIFFSFS : public FS {
+public:
+  SPIFFSFS() : FS("spiffs") {
+  }
+  bool begin(bool formatOnFail = false, const char *basePath = "/spiffs", uint8_t maxOpenFiles = 10, const char *partitionLabel = NULL);
+  bool format();
+  void end();
+};
+
+} // namespace fs
+
+extern fs::SPIFFSFS SPIFFS;
+
+#endif
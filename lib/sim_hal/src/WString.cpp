@@ -0,0 +1,225 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WString.h"
+
+static std::string integerToString(unsigned long long value, bool negative, unsigned char base) {
+  char  buf[66];
+  char *p = buf + sizeof(buf) - 1;
+  *p      = 0;
+  if (base < 2) {
+    base = 10;
+  }
+  do {
+    int digit = value % base;
+    *--p      = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value);
+  if (negative) {
+    *--p = '-';
+  }
+  return std::string(p);
+}
+
+static std::string signedToString(long long value, unsigned char base) {
+  if (base == 10 && value < 0) {
+    return integerToString(0ULL - (unsigned long long)value, true, base);
+  }
+  return integerToString((unsigned long)value, false, base);
+}
+
+static std::string floatToString(double value, unsigned char decimalPlaces) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  return std::string(buf);
+}
+
+String::String(const char *cstr) : mStr(cstr ? cstr : "") {
+}
+
+String::String(char c) : mStr(1, c) {
+}
+
+String::String(unsigned char value, unsigned char base) : mStr(integerToString(value, false, base)) {
+}
+
+String::String(int value, unsigned char base) : mStr(signedToString(value, base)) {
+}
+
+String::String(unsigned int value, unsigned char base) : mStr(integerToString(value, false, base)) {
+}
+
+String::String(long value, unsigned char base) : mStr(signedToString(value, base)) {
+}
+
+String::String(unsigned long value, unsigned char base) : mStr(integerToString(value, false, base)) {
+}
+
+String::String(float value, unsigned char decimalPlaces) : mStr(floatToString(value, decimalPlaces)) {
+}
+
+String::String(double value, unsigned char decimalPlaces) : mStr(floatToString(value, decimalPlaces)) {
+}
+
+String &String::operator=(const String &rhs) {
+  mStr = rhs.mStr;
+  return *this;
+}
+
+String &String::operator=(const char *cstr) {
+  mStr = cstr ? cstr : "";
+  return *this;
+}
+
+bool String::reserve(unsigned int size) {
+  mStr.reserve(size);
+  return true;
+}
+
+bool String::concat(const String &str) {
+  mStr += str.mStr;
+  return true;
+}
+
+bool String::concat(const char *cstr) {
+  if (!cstr) {
+    return false;
+  }
+  mStr += cstr;
+  return true;
+}
+
+bool String::concat(const char *cstr, unsigned int length) {
+  if (!cstr) {
+    return false;
+  }
+  mStr.append(cstr, length);
+  return true;
+}
+
+bool String::concat(char c) {
+  mStr += c;
+  return true;
+}
+
+bool String::concat(unsigned char num) {
+  return concat(String(num));
+}
+
+bool String::concat(int num) {
+  return concat(String(num));
+}
+
+bool String::concat(unsigned int num) {
+  return concat(String(num));
+}
+
+bool String::concat(long num) {
+  return concat(String(num));
+}
+
+bool String::concat(unsigned long num) {
+  return concat(String(num));
+}
+
+bool String::concat(float num) {
+  return concat(String(num));
+}
+
+bool String::concat(double num) {
+  return concat(String(num));
+}
+
+char String::charAt(unsigned int index) const {
+  return index < mStr.length() ? mStr[index] : 0;
+}
+
+char String::operator[](unsigned int index) const {
+  return charAt(index);
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+  size_t pos = mStr.find(ch, fromIndex);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const {
+  size_t pos = mStr.find(str.mStr, fromIndex);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+bool String::startsWith(const String &prefix) const {
+  return mStr.compare(0, prefix.mStr.length(), prefix.mStr) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+  return mStr.length() >= suffix.mStr.length() && mStr.compare(mStr.length() - suffix.mStr.length(), suffix.mStr.length(), suffix.mStr) == 0;
+}
+
+bool String::equals(const String &str) const {
+  return mStr == str.mStr;
+}
+
+bool String::equals(const char *cstr) const {
+  return mStr == (cstr ? cstr : "");
+}
+
+String String::substring(unsigned int beginIndex) const {
+  return substring(beginIndex, mStr.length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) {
+    std::swap(beginIndex, endIndex);
+  }
+  if (beginIndex >= mStr.length()) {
+    return String();
+  }
+  return String(mStr.substr(beginIndex, endIndex - beginIndex).c_str());
+}
+
+void String::trim() {
+  size_t begin = 0;
+  size_t end   = mStr.length();
+  while (begin < end && isspace((unsigned char)mStr[begin])) {
+    begin++;
+  }
+  while (end > begin && isspace((unsigned char)mStr[end - 1])) {
+    end--;
+  }
+  mStr = mStr.substr(begin, end - begin);
+}
+
+void String::toUpperCase() {
+  for (size_t i = 0; i < mStr.length(); i++) {
+    mStr[i] = toupper((unsigned char)mStr[i]);
+  }
+}
+
+void String::toLowerCase() {
+  for (size_t i = 0; i < mStr.length(); i++) {
+    mStr[i] = tolower((unsigned char)mStr[i]);
+  }
+}
+
+long String::toInt() const {
+  return atol(mStr.c_str());
+}
+
+float String::toFloat() const {
+  return atof(mStr.c_str());
+}
+
+String operator+(const char *lhs, const String &rhs) {
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+String operator+(char lhs, const String &rhs) {
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
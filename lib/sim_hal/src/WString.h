@@ -0,0 +1,97 @@
+#ifndef WSTRING_H_
+#define WSTRING_H_
+
+#include <stddef.h>
+#include <string>
+
+// Arduino String on top of std::string, enough for the firmware, TinyGPSPlus
+// and ArduinoJson.
+class String {
+public:
+  String(const char *cstr = "");
+  String(const String &str) : mStr(str.mStr) {
+  }
+  explicit String(char c);
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimalPlaces = 2);
+  explicit String(double value, unsigned char decimalPlaces = 2);
+
+  String &operator=(const String &rhs);
+  String &operator=(const char *cstr);
+
+  bool reserve(unsigned int size);
+  bool concat(const String &str);
+  bool concat(const char *cstr);
+  bool concat(const char *cstr, unsigned int length);
+  bool concat(char c);
+  bool concat(unsigned char num);
+  bool concat(int num);
+  bool concat(unsigned int num);
+  bool concat(long num);
+  bool concat(unsigned long num);
+  bool concat(float num);
+  bool concat(double num);
+
+  template <typename T> String &operator+=(const T &rhs) {
+    concat(rhs);
+    return *this;
+  }
+
+  unsigned int length() const {
+    return mStr.length();
+  }
+  const char *c_str() const {
+    return mStr.c_str();
+  }
+
+  char charAt(unsigned int index) const;
+  char operator[](unsigned int index) const;
+  int  indexOf(char ch, unsigned int fromIndex = 0) const;
+  int  indexOf(const String &str, unsigned int fromIndex = 0) const;
+  bool startsWith(const String &prefix) const;
+  bool endsWith(const String &suffix) const;
+  bool equals(const String &str) const;
+  bool equals(const char *cstr) const;
+
+  String substring(unsigned int beginIndex) const;
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+  void   trim();
+  void   toUpperCase();
+  void   toLowerCase();
+  long   toInt() const;
+  float  toFloat() const;
+
+  bool operator==(const String &rhs) const {
+    return equals(rhs);
+  }
+  bool operator==(const char *cstr) const {
+    return equals(cstr);
+  }
+  bool operator!=(const String &rhs) const {
+    return !equals(rhs);
+  }
+  bool operator!=(const char *cstr) const {
+    return !equals(cstr);
+  }
+  bool operator<(const String &rhs) const {
+    return mStr < rhs.mStr;
+  }
+
+private:
+  std::string mStr;
+};
+
+template <typename T> String operator+(const String &lhs, const T &rhs) {
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+String operator+(const char *lhs, const String &rhs);
+String operator+(char lhs, const String &rhs);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef WIFI_H_
+#define WIFI_H_
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA,
+  WIFI_AP,
+  WIFI_AP_STA
+} wifi_mode_t;
+
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t m) {
+    (void)m;
+    return true;
+  }
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,62 @@
+#include "Wire.h"
+#include "sim.h"
+
+TwoWire Wire;
+
+static void busTime(size_t bytes, uint32_t clock) {
+  // address byte included, 9 clocks per byte with the ACK
+  sim::stats().i2c_bytes += bytes;
+  sim::advance_us((uint64_t)(bytes + 1) * 9 * 1000000 / clock);
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+  (void)sda;
+  (void)scl;
+  if (frequency) {
+    mClock = frequency;
+  }
+  return true;
+}
+
+void TwoWire::setClock(uint32_t frequency) {
+  mClock = frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  mAddress  = address;
+  mTxLength = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  (void)sendStop;
+  busTime(mTxLength, mClock);
+  mTxLength = 0;
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop) {
+  (void)address;
+  (void)sendStop;
+  busTime(quantity, mClock);
+  return 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  (void)data;
+  mTxLength++;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+  (void)data;
+  mTxLength += quantity;
+  return quantity;
+}
+
+int TwoWire::available() {
+  return 0;
+}
+
+int TwoWire::read() {
+  return -1;
+}
@@ -0,0 +1,33 @@
+#ifndef WIRE_H_
+#define WIRE_H_
+
+#include "Stream.h"
+
+// I2C master that only accounts bus time and bytes in the simulation.
+class TwoWire : public Stream {
+public:
+  TwoWire() : mClock(100000), mAddress(0), mTxLength(0) {
+  }
+
+  bool    begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+  void    setClock(uint32_t frequency);
+  void    beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t *data, size_t quantity) override;
+  int    available() override;
+  int    read() override;
+
+  using Print::write;
+
+private:
+  uint32_t mClock;
+  uint8_t  mAddress;
+  size_t   mTxLength;
+};
+
+extern TwoWire Wire;
+
+#endif
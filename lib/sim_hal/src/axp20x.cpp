@@ -0,0 +1,82 @@
+#include "axp20x.h"
+#include "sim.h"
+
+static const double CellCapacity_mAh = 2600.0;
+
+// the AXP192 keeps counting while the ESP32 reboots
+static double SIM_RETAINED gCoulombOffset_mAh;
+
+AXP20X_Class::AXP20X_Class() {
+}
+
+int AXP20X_Class::begin(TwoWire &port, uint8_t addr, bool isAxp173) {
+  (void)port;
+  (void)addr;
+  (void)isAxp173;
+  return AXP_PASS;
+}
+
+int AXP20X_Class::setPowerOutPut(uint8_t ch, bool en) {
+  if (ch == AXP192_LDO3) {
+    sim::gps_power(en);
+  }
+  return AXP_PASS;
+}
+
+bool AXP20X_Class::isChannelAvaliable(uint8_t channel) {
+  (void)channel;
+  return true;
+}
+
+int AXP20X_Class::setDCDC1Voltage(uint16_t mv) {
+  (void)mv;
+  return AXP_PASS;
+}
+
+int AXP20X_Class::setChgLEDMode(axp_chgled_mode_t mode) {
+  (void)mode;
+  return AXP_PASS;
+}
+
+int AXP20X_Class::adc1Enable(uint16_t params, bool en) {
+  (void)params;
+  (void)en;
+  return AXP_PASS;
+}
+
+// linear between full (4.2 V) and empty (3.3 V), good enough to drive the
+// firmware's battery logic
+float AXP20X_Class::getBattVoltage() {
+  double used = sim::stats().mAh / CellCapacity_mAh;
+  return (float)(4200.0 - 900.0 * min(used, 1.0));
+}
+
+float AXP20X_Class::getBattChargeCurrent() {
+  return 0.0f;
+}
+
+float AXP20X_Class::getBattDischargeCurrent() {
+  return sim::current_mA();
+}
+
+bool AXP20X_Class::isChargeing() {
+  return false;
+}
+
+bool AXP20X_Class::isBatteryConnect() {
+  return true;
+}
+
+int AXP20X_Class::enableChargeing(bool en) {
+  (void)en;
+  return AXP_PASS;
+}
+
+float AXP20X_Class::getCoulombData() {
+  return (float)-(sim::stats().mAh - gCoulombOffset_mAh);
+}
+
+int AXP20X_Class::ClearCoulombcounter() {
+  gCoulombOffset_mAh = sim::stats().mAh;
+  return AXP_PASS;
+}
@@ -0,0 +1,56 @@
+#ifndef AXP20X_H_
+#define AXP20X_H_
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define AXP192_SLAVE_ADDRESS 0x34
+
+#define AXP_PASS 0
+#define AXP_FAIL -1
+
+#define AXP202_ON  1
+#define AXP202_OFF 0
+
+#define AXP202_BATT_VOL_ADC1 (1 << 7)
+#define AXP202_BATT_CUR_ADC1 (1 << 6)
+
+enum {
+  AXP192_DCDC1 = 0,
+  AXP192_DCDC3 = 1,
+  AXP192_LDO2  = 2,
+  AXP192_LDO3  = 3,
+  AXP192_DCDC2 = 4,
+  AXP192_EXTEN = 6,
+};
+
+typedef enum {
+  AXP20X_LED_OFF,
+  AXP20X_LED_BLINK_1HZ,
+  AXP20X_LED_BLINK_4HZ,
+  AXP20X_LED_LOW_LEVEL,
+} axp_chgled_mode_t;
+
+// AXP192 stand-in. LDO3 powers the simulated GPS, the fuel gauge integrates
+// the simulated load current of an 18650 cell.
+class AXP20X_Class {
+public:
+  AXP20X_Class();
+
+  int   begin(TwoWire &port = Wire, uint8_t addr = AXP192_SLAVE_ADDRESS, bool isAxp173 = false);
+  int   setPowerOutPut(uint8_t ch, bool en);
+  bool  isChannelAvaliable(uint8_t channel);
+  int   setDCDC1Voltage(uint16_t mv);
+  int   setChgLEDMode(axp_chgled_mode_t mode);
+  int   adc1Enable(uint16_t params, bool en);
+  float getBattVoltage();
+  float getBattChargeCurrent();
+  float getBattDischargeCurrent();
+  bool  isChargeing();
+  bool  isBatteryConnect();
+  int   enableChargeing(bool en);
+  float getCoulombData();
+  int   ClearCoulombcounter();
+};
+
+#endif
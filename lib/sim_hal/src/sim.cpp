@@ -0,0 +1,772 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "sim.h"
+
+void setup();
+void loop();
+
+namespace sim {
+
+static Options               gOptions;
+static Stats SIM_RETAINED    gStats;
+static uint64_t SIM_RETAINED gNow_us;
+static float SIM_RETAINED    gLoad_mA[LoadCount];
+static uint64_t              gBoot_us;
+static bool                  gSleeping;
+static bool                  gDeepSleeping;
+static int                   gCpu_mhz = 240;
+static char                **gArgv;
+#ifndef PIO_UNIT_TESTING
+static const char           *gResumePath;
+#endif
+
+const Options &options() {
+  return gOptions;
+}
+
+Stats &stats() {
+  return gStats;
+}
+
+uint64_t now_us() {
+  return gNow_us;
+}
+
+uint64_t boot_us() {
+  return gBoot_us;
+}
+
+float current_mA() {
+  float total = gSleeping ? (gDeepSleeping ? CpuDeep_mA : CpuLight_mA) : CpuBase_mA + CpuPerMhz_mA * gCpu_mhz;
+  for (int i = LoadGps; i < LoadCount; i++) {
+    total += gLoad_mA[i];
+  }
+  return total;
+}
+
+void advance_us(uint64_t us) {
+  gStats.mAh += current_mA() * (double)us / 3.6e9;
+  if (gSleeping) {
+    gStats.sleep_us += us;
+  } else {
+    gStats.awake_us += us;
+    if (gCpu_mhz < 240) {
+      gStats.below_max_us += us;
+    }
+  }
+  if (gps_active()) {
+    gStats.gps_on_us += us;
+  }
+  gNow_us += us;
+}
+
+void set_load(Load load, float mA) {
+  gLoad_mA[load] = mA;
+}
+
+bool sleeping() {
+  return gSleeping;
+}
+
+void set_sleeping(bool sleep, bool deep) {
+  gSleeping     = sleep;
+  gDeepSleeping = sleep && deep;
+}
+
+int cpu_mhz() {
+  return gCpu_mhz;
+}
+
+void set_cpu_mhz(int mhz) {
+  gCpu_mhz = mhz;
+}
+
+void log(const char *fmt, ...) {
+  uint64_t ms = gNow_us / 1000;
+  printf("[sim %02u:%02u:%02u.%03u] ", (unsigned)(ms / 3600000), (unsigned)(ms / 60000 % 60), (unsigned)(ms / 1000 % 60), (unsigned)(ms % 1000));
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+  printf("\n");
+}
+
+// GPS receiver: the recording is cut into one-second epochs at each RMC
+// sentence and replayed against the simulated clock at the receiver's baud
+// rate, looping at the end. The UTC time and date of the sentences go on
+// from the first RMC with the simulated clock, across the loops. Until it has
+// a fix after power-on it sends empty sentences, nothing while it is in backup
+// or when the host UART runs at another rate. UBX answers are queued ahead of
+// the NMEA.
+static std::vector<std::string> gEpochs;
+static time_t                   gRecordingStart;
+static bool SIM_RETAINED gGpsPowered;
+static bool SIM_RETAINED gGpsPowerSave;
+static bool SIM_RETAINED gGpsBackup;
+static uint64_t SIM_RETAINED gGpsBackupEnd_us;
+static uint64_t SIM_RETAINED gGpsFix_us;
+static uint64_t                 gReadEpoch = UINT64_MAX;
+static size_t                   gReadOffset;
+static std::string              gEpochOut;
+static uint32_t SIM_RETAINED gGpsBaud;
+static uint32_t                 gHostBaud;
+static uint8_t SIM_RETAINED gNmeaOff; // bit per UBX NMEA id turned off
+static std::string              gUbxOut;
+static std::string              gUbxIn;
+static bool SIM_RETAINED gAidTime;
+static int SIM_RETAINED gAidEphemerides;
+// SVs with an ephemeris once the receiver has tracked for a while
+static const int                TrackedSvs = 9;
+
+static void loadRecording() {
+  FILE *f = fopen(gOptions.nmea_path, "r");
+  if (!f) {
+    fprintf(stderr, "sim: cannot open NMEA recording %s\n", gOptions.nmea_path);
+    exit(1);
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    size_t len = strcspn(line, "\r\n");
+    if (len == 0 || line[0] != '$') {
+      continue;
+    }
+    if (gEpochs.empty() || (len > 6 && strncmp(line + 3, "RMC", 3) == 0)) {
+      gEpochs.push_back(std::string());
+    }
+    gEpochs.back().append(line, len);
+    gEpochs.back().append("\r\n");
+  }
+  fclose(f);
+  for (size_t i = 0; i < gEpochs.size() && !gRecordingStart; i++) {
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    const char *rmc = strstr(gEpochs[i].c_str(), "RMC,");
+    if (rmc && sscanf(rmc, "RMC,%2d%2d%2d", &t.tm_hour, &t.tm_min, &t.tm_sec) == 3) {
+      const char *date = rmc;
+      for (int field = 0; field < 9 && date; field++) {
+        date = strchr(date + 1, ',');
+      }
+      if (date && sscanf(date, ",%2d%2d%2d", &t.tm_mday, &t.tm_mon, &t.tm_year) == 3) {
+        t.tm_mon -= 1;
+        t.tm_year += 100;
+        gRecordingStart = timegm(&t) - (time_t)i;
+      }
+    }
+  }
+  if (gEpochs.empty()) {
+    fprintf(stderr, "sim: no NMEA sentences in %s\n", gOptions.nmea_path);
+    exit(1);
+  }
+}
+
+static const char *const NmeaIds[] = {"GGA", "GLL", "GSA", "GSV", "RMC", "VTG"};
+
+static std::string nmeaSentence(const char *body) {
+  uint8_t cs = 0;
+  for (const char *p = body; *p; p++) {
+    cs ^= (uint8_t)*p;
+  }
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", cs);
+  return std::string("$") + body + tail;
+}
+
+// Time fields of RMC, GGA and GLL set to the UTC of the epoch.
+static std::string restamp(const std::string &sentences, uint64_t epoch) {
+  time_t    utc = gRecordingStart + (time_t)epoch;
+  struct tm t;
+  gmtime_r(&utc, &t);
+  char hms[16];
+  char dmy[8];
+  snprintf(hms, sizeof(hms), "%02u%02u%02u.00", (unsigned)t.tm_hour % 100, (unsigned)t.tm_min % 100, (unsigned)t.tm_sec % 100);
+  snprintf(dmy, sizeof(dmy), "%02u%02u%02u", (unsigned)t.tm_mday % 100, (unsigned)(t.tm_mon + 1) % 100, (unsigned)t.tm_year % 100);
+  std::string out;
+  size_t      start = 0;
+  while (start < sentences.size()) {
+    size_t      end       = sentences.find('\n', start) + 1;
+    std::string line      = sentences.substr(start, end - start);
+    size_t      star      = line.find('*');
+    int         timeField = -1;
+    int         dateField = -1;
+    if (line.compare(3, 3, "RMC") == 0) {
+      timeField = 1;
+      dateField = 9;
+    } else if (line.compare(3, 3, "GGA") == 0) {
+      timeField = 1;
+    } else if (line.compare(3, 3, "GLL") == 0) {
+      timeField = 5;
+    }
+    if (timeField < 0 || star == std::string::npos || !gRecordingStart) {
+      out += line;
+    } else {
+      std::string body = line.substr(1, star - 1);
+      std::string stamped;
+      size_t      from = 0;
+      for (int field = 0; from != std::string::npos; field++) {
+        size_t      comma = body.find(',', from);
+        std::string value = body.substr(from, comma == std::string::npos ? std::string::npos : comma - from);
+        stamped += field == timeField && !value.empty() ? hms : (field == dateField && !value.empty() ? dmy : value.c_str());
+        if (comma != std::string::npos) {
+          stamped += ',';
+          from = comma + 1;
+        } else {
+          from = std::string::npos;
+        }
+      }
+      out += nmeaSentence(stamped.c_str());
+    }
+    start = end;
+  }
+  return out;
+}
+
+// What the receiver sends in this epoch, less the sentences turned off.
+static void buildEpoch(uint64_t epoch) {
+  std::string sentences;
+  if (gNow_us < gGpsFix_us) {
+    sentences = nmeaSentence("GPRMC,,V,,,,,,,,,,N") + nmeaSentence("GPVTG,,,,,,,,,N") + nmeaSentence("GPGGA,,,,,,0,00,99.99,,,,,,") + nmeaSentence("GPGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99") +
+                nmeaSentence("GPGSV,1,1,00") + nmeaSentence("GPGLL,,,,,,V,N");
+  } else {
+    sentences = restamp(gEpochs[epoch % gEpochs.size()], epoch);
+  }
+  gEpochOut.clear();
+  size_t start = 0;
+  while (start < sentences.size()) {
+    size_t end  = sentences.find('\n', start) + 1;
+    bool   keep = true;
+    for (int id = 0; id < 6; id++) {
+      if ((gNmeaOff & (1 << id)) && sentences.compare(start + 3, 3, NmeaIds[id]) == 0) {
+        keep = false;
+      }
+    }
+    if (keep) {
+      gEpochOut.append(sentences, start, end - start);
+    }
+    start = end;
+  }
+}
+
+static void gpsLoad() {
+  float mA = 0.0f;
+  if (gGpsPowered) {
+    mA = gGpsBackup ? GpsBackup_mA : (gGpsPowerSave ? GpsPowerSave_mA : GpsAcquire_mA);
+  }
+  set_load(LoadGps, mA);
+}
+
+static void gpsLeaveBackup() {
+  gGpsBackup = false;
+  gGpsFix_us = gNow_us + (uint64_t)gOptions.gps_hot_ttff_ms * 1000;
+  gpsLoad();
+  if (gOptions.verbose) {
+    log("GPS leaves backup");
+  }
+}
+
+static void ubxQueue(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len) {
+  std::string frame;
+  frame += (char)0xB5;
+  frame += (char)0x62;
+  frame += (char)msg_class;
+  frame += (char)msg_id;
+  frame += (char)(len & 0xFF);
+  frame += (char)(len >> 8);
+  frame.append((const char *)payload, len);
+  uint8_t ck_a = 0;
+  uint8_t ck_b = 0;
+  for (size_t i = 2; i < frame.size(); i++) {
+    ck_a += (uint8_t)frame[i];
+    ck_b += ck_a;
+  }
+  frame += (char)ck_a;
+  frame += (char)ck_b;
+  gUbxOut += frame;
+}
+
+static uint32_t le32(const uint8_t *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void aidReceived(uint8_t msg_id, const uint8_t *payload, uint16_t len) {
+  if (msg_id == 0x31 && len == 0) {
+    bool tracking = gps_active() && gNow_us >= gGpsFix_us;
+    for (uint32_t sv = 1; sv <= 32; sv++) {
+      uint8_t eph[104];
+      memset(eph, 0, sizeof(eph));
+      eph[0] = sv;
+      ubxQueue(0x0B, 0x31, eph, tracking && sv <= TrackedSvs ? sizeof(eph) : 8);
+    }
+    return;
+  }
+  if (msg_id == 0x01 && len == 48) {
+    gAidTime = (le32(payload + 44) & 0x02) != 0;
+  } else if (msg_id == 0x31 && len == 104) {
+    gAidEphemerides++;
+  }
+  // time and ephemerides for enough SVs make it close to a hot start
+  uint64_t aided_us = gNow_us + (uint64_t)gOptions.gps_aided_ttff_ms * 1000;
+  if (gAidTime && gAidEphemerides >= 4 && aided_us < gGpsFix_us) {
+    gGpsFix_us = aided_us;
+    if (gOptions.verbose) {
+      log("GPS aided start");
+    }
+  }
+}
+
+static void ubxReceived(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len) {
+  if (msg_class == 0x0B) {
+    aidReceived(msg_id, payload, len);
+  } else if (msg_class == 0x06) {
+    if (msg_id == 0x00 && len == 20) {
+      // answered at the new rate
+      gGpsBaud = le32(payload + 8);
+    } else if (msg_id == 0x01 && len >= 3 && payload[0] == 0xF0 && payload[1] < 6) {
+      uint8_t rate = len == 3 ? payload[2] : payload[3];
+      gNmeaOff     = rate ? gNmeaOff & ~(1 << payload[1]) : gNmeaOff | (1 << payload[1]);
+    } else if (msg_id == 0x11 && len >= 2) {
+      gGpsPowerSave = payload[1] != 0;
+      gpsLoad();
+    }
+    const uint8_t ack[2] = {msg_class, msg_id};
+    ubxQueue(0x05, 0x01, ack, sizeof(ack));
+  } else if (msg_class == 0x02 && msg_id == 0x41 && len >= 8 && (le32(payload + 4) & 0x02)) {
+    uint32_t duration_ms = le32(payload);
+    gGpsBackup           = true;
+    gGpsBackupEnd_us     = duration_ms ? gNow_us + (uint64_t)duration_ms * 1000 : UINT64_MAX;
+    gpsLoad();
+    if (gOptions.verbose) {
+      log("GPS backup for %u ms", duration_ms);
+    }
+  }
+}
+
+void gps_power(bool on) {
+  if (on && !gGpsPowered) {
+    gGpsFix_us    = gNow_us + (uint64_t)gOptions.gps_ttff_ms * 1000;
+    gGpsBackup      = false;
+    gGpsPowerSave   = false;
+    gAidTime        = false;
+    gAidEphemerides = 0;
+    gGpsBaud        = 9600;
+    gNmeaOff        = 0;
+    gUbxIn.clear();
+    gUbxOut.clear();
+  }
+  gGpsPowered = on;
+  gpsLoad();
+}
+
+bool gps_powered() {
+  return gGpsPowered;
+}
+
+bool gps_active() {
+  return gGpsPowered && !gGpsBackup;
+}
+
+int gps_available() {
+  if (!gGpsPowered) {
+    return 0;
+  }
+  if (gGpsBackup && gNow_us >= gGpsBackupEnd_us) {
+    gpsLeaveBackup();
+  }
+  if (gGpsBackup || gHostBaud != gGpsBaud) {
+    return 0;
+  }
+  if (!gUbxOut.empty()) {
+    return (int)gUbxOut.size();
+  }
+  if (gEpochs.empty()) {
+    loadRecording();
+  }
+  uint64_t epoch = gNow_us / 1000000;
+  if (epoch != gReadEpoch) {
+    gReadEpoch  = epoch;
+    gReadOffset = 0;
+    buildEpoch(epoch);
+  }
+  size_t sent = min((size_t)(gNow_us % 1000000 * (gGpsBaud / 10) / 1000000), gEpochOut.size());
+  return sent > gReadOffset ? (int)(sent - gReadOffset) : 0;
+}
+
+int gps_read() {
+  if (gps_available() <= 0) {
+    return -1;
+  }
+  if (!gUbxOut.empty()) {
+    uint8_t c = gUbxOut[0];
+    gUbxOut.erase(0, 1);
+    return c;
+  }
+  return (uint8_t)gEpochOut[gReadOffset++];
+}
+
+void gps_uart_baud(uint32_t baud) {
+  gHostBaud = baud;
+}
+
+void gps_write(const uint8_t *data, size_t len) {
+  if (!gGpsPowered) {
+    return;
+  }
+  if (gGpsBackup) {
+    // any edge on RX wakes the receiver, the bytes themselves are lost
+    gpsLeaveBackup();
+    return;
+  }
+  if (gHostBaud != gGpsBaud) {
+    return;
+  }
+  gUbxIn.append((const char *)data, len);
+  for (;;) {
+    size_t sync = gUbxIn.find("\xB5\x62");
+    if (sync == std::string::npos) {
+      gUbxIn.clear();
+      return;
+    }
+    gUbxIn.erase(0, sync);
+    if (gUbxIn.size() < 8) {
+      return;
+    }
+    const uint8_t *frame = (const uint8_t *)gUbxIn.data();
+    uint16_t       plen  = frame[4] | frame[5] << 8;
+    if (gUbxIn.size() < (size_t)plen + 8) {
+      return;
+    }
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+    for (size_t i = 2; i < (size_t)plen + 6; i++) {
+      ck_a += frame[i];
+      ck_b += ck_a;
+    }
+    if (ck_a == frame[plen + 6] && ck_b == frame[plen + 7]) {
+      ubxReceived(frame[2], frame[3], frame + 6, plen);
+    }
+    gUbxIn.erase(0, plen + 8);
+  }
+}
+
+// Start times of the last frames of other stations, a Poisson process that
+// goes on over a deep sleep.
+static const int             TrafficKept = 8;
+static uint64_t SIM_RETAINED gTrafficState = 88172645463325252ULL;
+static uint64_t SIM_RETAINED gTrafficStart_us[TrafficKept];
+static uint32_t SIM_RETAINED gTrafficFrames;
+
+static double trafficUniform() {
+  gTrafficState ^= gTrafficState << 13;
+  gTrafficState ^= gTrafficState >> 7;
+  gTrafficState ^= gTrafficState << 17;
+  return (gTrafficState >> 11) * (1.0 / 9007199254740992.0);
+}
+
+bool channel_busy(uint64_t from_us, uint64_t to_us) {
+  if (gOptions.traffic_per_hour <= 0) {
+    return false;
+  }
+  double mean_us = 3.6e9 / gOptions.traffic_per_hour;
+  while (gTrafficFrames == 0 || gTrafficStart_us[(gTrafficFrames - 1) % TrafficKept] <= to_us) {
+    uint64_t last = gTrafficFrames ? gTrafficStart_us[(gTrafficFrames - 1) % TrafficKept] : 0;
+    gTrafficStart_us[gTrafficFrames % TrafficKept] = last + (uint64_t)(-::log(1.0 - trafficUniform()) * mean_us);
+    gTrafficFrames++;
+  }
+  for (uint32_t i = 0; i < min(gTrafficFrames, (uint32_t)TrafficKept); i++) {
+    if (gTrafficStart_us[i] < to_us && gTrafficStart_us[i] + TrafficFrame_us > from_us) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// --console SEC:TEXT lines, in the order given
+struct ConsoleLine {
+  uint64_t    at_us;
+  std::string text;
+};
+static std::vector<ConsoleLine> gConsole;
+static size_t SIM_RETAINED      gConsoleOffset;
+static size_t SIM_RETAINED      gConsoleDone; // lines read before a reboot
+
+int console_available() {
+  if (gConsole.empty() || gConsole.front().at_us > gNow_us) {
+    return 0;
+  }
+  return (int)(gConsole.front().text.size() - gConsoleOffset);
+}
+
+int console_read() {
+  if (console_available() <= 0) {
+    return -1;
+  }
+  int c = (uint8_t)gConsole.front().text[gConsoleOffset++];
+  if (gConsoleOffset == gConsole.front().text.size()) {
+    gConsole.erase(gConsole.begin());
+    gConsoleOffset = 0;
+    gConsoleDone++;
+  }
+  return c;
+}
+
+extern "C" char __start_sim_retained[];
+extern "C" char __stop_sim_retained[];
+
+static void saveRetained(const char *path) {
+  FILE *f = fopen(path, "wb");
+  if (!f || fwrite(__start_sim_retained, 1, __stop_sim_retained - __start_sim_retained, f) != (size_t)(__stop_sim_retained - __start_sim_retained)) {
+    fprintf(stderr, "sim: cannot write %s\n", path);
+    exit(1);
+  }
+  fclose(f);
+}
+
+static void report() {
+  double hours = gNow_us / 3.6e9;
+  printf("\n=== simulated %.2f h ===\n", hours);
+  printf("wakes            %10u  (%.1f/h)\n", gStats.wakes, gStats.wakes / hours);
+  if (gStats.deep_wakes) {
+    printf("  from deep sleep %9u\n", gStats.deep_wakes);
+  }
+  printf("frames           %10u  (%.1f/h)\n", gStats.frames, gStats.frames / hours);
+  printf("bytes sent       %10u  (%.1f/h)\n", gStats.tx_bytes, gStats.tx_bytes / hours);
+  printf("airtime          %10.1f s (%.1f s/h)\n", gStats.tx_us / 1e6, gStats.tx_us / 1e6 / hours);
+  printf("awake            %10.1f s (%.1f s/h)\n", gStats.awake_us / 1e6, gStats.awake_us / 1e6 / hours);
+  printf("  below 240 MHz  %10.1f s\n", gStats.below_max_us / 1e6);
+  printf("GPS on           %10.1f s (%.1f s/h)\n", gStats.gps_on_us / 1e6, gStats.gps_on_us / 1e6 / hours);
+  printf("display flushes  %10u\n", gStats.display_flushes);
+  printf("I2C bytes        %10llu\n", (unsigned long long)gStats.i2c_bytes);
+  if (gOptions.traffic_per_hour > 0) {
+    printf("CADs             %10u\n", gStats.cads);
+    printf("collisions       %10u\n", gStats.collisions);
+  }
+  printf("charge           %10.2f mAh (avg %.2f mA)\n", gStats.mAh, gStats.mAh / hours);
+  if (gStats.frames) {
+    printf("per frame        %10.3f mAh\n", gStats.mAh / gStats.frames);
+  }
+}
+
+// pio test links its own main() with the sources and this library.
+#ifndef PIO_UNIT_TESTING
+static void loadRetained(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f || fread(__start_sim_retained, 1, __stop_sim_retained - __start_sim_retained, f) != (size_t)(__stop_sim_retained - __start_sim_retained)) {
+    fprintf(stderr, "sim: cannot read %s\n", path);
+    exit(1);
+  }
+  fclose(f);
+  unlink(path);
+  gConsole.erase(gConsole.begin(), gConsole.begin() + min(gConsoleDone, gConsole.size()));
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [--nmea FILE] [--fs DIR] [--hours H] [--ttff MS] [--hot-ttff MS] [--aided-ttff MS] [--traffic N] [--console SEC:TEXT]... [-v]\n", argv0);
+  exit(2);
+}
+
+static void parseArgs(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (!strcmp(arg, "-v")) {
+      gOptions.verbose = true;
+    } else if (i + 1 >= argc) {
+      usage(argv[0]);
+    } else if (!strcmp(arg, "--nmea")) {
+      gOptions.nmea_path = argv[++i];
+    } else if (!strcmp(arg, "--fs")) {
+      gOptions.fs_dir = argv[++i];
+    } else if (!strcmp(arg, "--hours")) {
+      gOptions.hours = atof(argv[++i]);
+    } else if (!strcmp(arg, "--ttff")) {
+      gOptions.gps_ttff_ms = atoi(argv[++i]);
+    } else if (!strcmp(arg, "--hot-ttff")) {
+      gOptions.gps_hot_ttff_ms = atoi(argv[++i]);
+    } else if (!strcmp(arg, "--console")) {
+      ConsoleLine line;
+      char       *text = NULL;
+      line.at_us       = (uint64_t)(strtod(argv[++i], &text) * 1e6);
+      if (*text != ':') {
+        usage(argv[0]);
+      }
+      line.text = std::string(text + 1) + "\n";
+      gConsole.push_back(line);
+    } else if (!strcmp(arg, "--resume")) {
+      gResumePath = argv[++i];
+    } else if (!strcmp(arg, "--aided-ttff")) {
+      gOptions.gps_aided_ttff_ms = atoi(argv[++i]);
+    } else if (!strcmp(arg, "--traffic")) {
+      gOptions.traffic_per_hour = atof(argv[++i]);
+    } else {
+      usage(argv[0]);
+    }
+  }
+}
+#endif
+
+void deep_sleep(uint64_t time_us) {
+  uint64_t end_us = (uint64_t)(gOptions.hours * 3.6e9);
+  set_sleeping(true, true);
+  advance_us(gNow_us < end_us ? min(time_us, end_us - gNow_us) : 0);
+  set_sleeping(false);
+  gStats.wakes++;
+  gStats.deep_wakes++;
+  if (gNow_us >= end_us) {
+    report();
+    exit(0);
+  }
+  // the new program image starts with whatever the old one retained
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/sim-retained-%d", (int)getpid());
+  saveRetained(path);
+  std::vector<char *> args;
+  for (char **arg = gArgv; *arg; arg++) {
+    if (!strcmp(*arg, "--resume")) {
+      arg++;
+      continue;
+    }
+    args.push_back(*arg);
+  }
+  args.push_back((char *)"--resume");
+  args.push_back(path);
+  args.push_back(NULL);
+  fflush(stdout);
+  execv("/proc/self/exe", args.data());
+  perror("sim: execv");
+  exit(1);
+}
+
+} // namespace sim
+
+// Arduino core and ESP-IDF calls used by the firmware
+
+static uint64_t                              gTimerWakeup_us;
+static esp_sleep_wakeup_cause_t SIM_RETAINED gWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+// both start again from 0 after a deep sleep
+unsigned long millis() {
+  return (unsigned long)((sim::now_us() - sim::boot_us()) / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)(sim::now_us() - sim::boot_us());
+}
+
+void delay(uint32_t ms) {
+  sim::advance_us((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+  sim::advance_us(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin == LORA_CS) {
+    sim::sx127x_select(val == LOW);
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  (void)pin;
+  return HIGH;
+}
+
+// the ESP32 takes it from its hardware RNG, here it repeats from run to run
+long random(long howbig) {
+  return howbig > 0 ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig) {
+  return howsmall < howbig ? howsmall + random(howbig - howsmall) : howsmall;
+}
+
+bool btStop() {
+  return true;
+}
+
+bool setCpuFrequencyMhz(uint32_t cpu_freq_mhz) {
+  if (cpu_freq_mhz != 80 && cpu_freq_mhz != 160 && cpu_freq_mhz != 240) {
+    return false;
+  }
+  sim::set_cpu_mhz(cpu_freq_mhz);
+  return true;
+}
+
+uint32_t getCpuFrequencyMhz() {
+  return sim::cpu_mhz();
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+  (void)gpio_num;
+  (void)intr_type;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+  gTimerWakeup_us = time_in_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start() {
+  uint64_t end_us = (uint64_t)(sim::options().hours * 3.6e9);
+  uint64_t period = gTimerWakeup_us ? gTimerWakeup_us : end_us - min(end_us, sim::now_us());
+  sim::set_sleeping(true);
+  sim::advance_us(period);
+  sim::set_sleeping(false);
+  sim::stats().wakes++;
+  gWakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level) {
+  (void)gpio_num;
+  (void)level;
+  return ESP_OK;
+}
+
+void esp_deep_sleep_start() {
+  uint64_t period = gTimerWakeup_us;
+  gWakeupCause    = ESP_SLEEP_WAKEUP_TIMER;
+  sim::deep_sleep(period);
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+  return gWakeupCause;
+}
+
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv) {
+  sim::gArgv = argv;
+  sim::parseArgs(argc, argv);
+  if (sim::gResumePath) {
+    sim::loadRetained(sim::gResumePath);
+  } else {
+    gWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+  }
+  sim::gBoot_us = sim::now_us();
+  uint64_t end_us = (uint64_t)(sim::options().hours * 3.6e9);
+  setup();
+  while (sim::now_us() < end_us) {
+    loop();
+  }
+  sim::report();
+  return 0;
+}
+#endif
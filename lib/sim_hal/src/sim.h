@@ -0,0 +1,117 @@
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// State that outlives a reboot of the simulated ESP32: RTC slow memory
+// (RTC_DATA_ATTR) and the parts of the board that stay powered. A deep sleep
+// re-executes the program with this section carried over.
+#define SIM_RETAINED __attribute__((section("sim_retained")))
+
+// Simulated T-Beam for the native build: a virtual clock, a current model of
+// the board loads and a replayed GPS receiver. The Arduino stand-ins in this
+// library call into it, the firmware never does.
+namespace sim {
+
+enum Load {
+  LoadCpu,
+  LoadGps,
+  LoadLoRa,
+  LoadOled,
+  LoadCount
+};
+
+// Current draw in mA of each load, taken from the datasheets of the parts on
+// the T-Beam V1.0.
+const float CpuBase_mA      = 15.0f;  // active: 25 mA at 80 MHz, 45 mA at 240
+const float CpuPerMhz_mA    = 0.125f;
+const float CpuLight_mA     = 0.8f;
+const float CpuDeep_mA      = 0.01f;
+const float GpsAcquire_mA   = 45.0f;
+const float GpsPowerSave_mA = 11.0f;
+const float GpsBackup_mA    = 0.02f;
+const float LoRaTx20dBm_mA  = 120.0f;
+const float LoRaIdle_mA     = 1.6f;
+const float LoRaRx_mA       = 11.5f;
+const float OledOn_mA       = 8.0f;
+
+struct Options {
+  Options() : nmea_path("sim/sample.nmea"), fs_dir("sim"), hours(1.0), gps_ttff_ms(30000), gps_hot_ttff_ms(1000), gps_aided_ttff_ms(5000), traffic_per_hour(0.0), verbose(false) {
+  }
+  const char *nmea_path;
+  const char *fs_dir;
+  double      hours;
+  unsigned    gps_ttff_ms;       // after LDO3 comes back
+  unsigned    gps_hot_ttff_ms;   // after a UBX backup
+  unsigned    gps_aided_ttff_ms; // after power-up with AID-INI time and AID-EPH
+  double      traffic_per_hour;  // frames of other stations on the channel
+  bool        verbose;
+};
+
+struct Stats {
+  Stats() : awake_us(0), sleep_us(0), tx_us(0), gps_on_us(0), below_max_us(0), wakes(0), deep_wakes(0), frames(0), tx_bytes(0), display_flushes(0), i2c_bytes(0), cads(0), collisions(0), mAh(0.0) {
+  }
+  uint64_t awake_us;
+  uint64_t sleep_us;
+  uint64_t tx_us;
+  uint64_t gps_on_us;
+  uint64_t below_max_us; // awake under 240 MHz
+  uint32_t wakes;
+  uint32_t deep_wakes;
+  uint32_t frames;
+  uint32_t tx_bytes;
+  uint32_t display_flushes;
+  uint64_t i2c_bytes;
+  uint32_t cads;
+  uint32_t collisions; // frames sent over one of another station
+  double   mAh;
+};
+
+const Options &options();
+Stats         &stats();
+
+uint64_t now_us();
+void     advance_us(uint64_t us);
+void     set_load(Load load, float mA);
+float    current_mA();
+uint64_t boot_us(); // when the ESP32 last came out of reset
+bool     sleeping();
+void     set_sleeping(bool sleep, bool deep = false);
+int      cpu_mhz();
+void     set_cpu_mhz(int mhz); // 240 again after a reset
+
+// GPS receiver model, wired to HardwareSerial(1) and AXP192 LDO3. It answers
+// CFG messages with ACK-ACK, follows CFG-PRT, CFG-MSG, RXM-PMREQ backup and
+// CFG-RXM power save, answers AID-EPH polls and takes AID-INI/AID-EPH aiding.
+void    gps_power(bool on);
+bool    gps_powered();
+bool    gps_active(); // powered and not in backup
+int     gps_available();
+int     gps_read();
+void    gps_write(const uint8_t *data, size_t len);
+void    gps_uart_baud(uint32_t baud); // rate of the host side, 0 when closed
+
+// Other stations: --traffic frames per hour of TrafficFrame_us each, at
+// random times. True when one is on the air between from_us and to_us.
+const uint64_t TrafficFrame_us = 3000000;
+bool           channel_busy(uint64_t from_us, uint64_t to_us);
+
+// SX127x registers behind LORA_CS that the LoRa library does not reach, the
+// op mode and IRQ flags of a Channel Activity Detection.
+void    sx127x_select(bool selected);
+uint8_t sx127x_transfer(uint8_t data);
+
+// Console input given with --console, typed at its time.
+int console_available();
+int console_read();
+
+// Ends the program into a reboot after time_us of deep sleep, or into the
+// report when that is past the simulated duration.
+void deep_sleep(uint64_t time_us) __attribute__((noreturn));
+
+void log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+} // namespace sim
+
+#endif
@@ -4,11 +4,29 @@
 #include <TinyGPS++.h>
 #include <WiFi.h>
 
+#include "airtime.h"
+#include "beacon_frame.h"
+#include "beacon_slot.h"
+#include "boot_trace.h"
 #include "configuration.h"
+#include "cpu_clock.h"
 #include "display.h"
+#include "energy_governor.h"
+#include "energy_stats.h"
+#include "frame_builder.h"
+#include "geofence.h"
+#include "gps_aiding.h"
+#include "gps_task.h"
+#include "listen_before_talk.h"
+#include "nmea_reader.h"
 #include "pins.h"
+#include "position_batch.h"
+#include "position_filter.h"
 #include "power_management.h"
 #include "sensor.h"
+#include "smart_beacon.h"
+#include "track_log.h"
+#include "ubx.h"
 
 //#define Debug
 
@@ -16,38 +34,127 @@
 #define HasSynchGPS 1
 #define PrepBeacon  2
 #define Sleep       3
+#define WakeUp      4
 
-Configuration   mConfig;
-PowerManagement powerManagement;
-HardwareSerial  ss(1);
-TinyGPSPlus     gps;
-Adafruit_BMP280 bmp; // use I2C interface
+Configuration    mConfig;
+PowerManagement  powerManagement;
+HardwareSerial   ss(1);
+UbxGps           ubx(ss);
+GpsAiding        gpsAiding(ubx, "/aiding.bin");
+TinyGPSPlus      gps;
+NmeaReader       nmeaReader(ss, gps);
+GpsTask          gpsTask(nmeaReader, gps);
+GpsFix           gpsFix;
+AirtimeBudget    airtimeBudget;
+SmartBeacon      smartBeacon;
+EnergyStats      energyStats(powerManagement);
+EnergyGovernor   governor(powerManagement);
+BootTrace        bootTrace;
+CpuClock         cpuClock;
+ListenBeforeTalk lbt(LORA_CS);
+BeaconSlot       beaconSlot;
+PositionBatch    positionBatch;
+PositionFilter   positionFilter;
+Sensor           sensor(Wire);
+Geofence         geofence("/geofence.bin");
+TrackLog         trackLog("/track.log", "/track.old");
 
+// Kept in RTC memory over a deep sleep, everything else starts again from
+// setup() at each wake up.
+RTC_DATA_ATTR int                        iState;
+RTC_DATA_ATTR unsigned int               rate_limit_message_text;
+RTC_DATA_ATTR unsigned int               acquisition_failures;
+RTC_DATA_ATTR bool                       no_fix;
+RTC_DATA_ATTR long                       gps_baud;
+RTC_DATA_ATTR time_t                     rtc_time;
+RTC_DATA_ATTR uint32_t                   rtc_sleep_ms;
+RTC_DATA_ATTR SmartBeacon::Retained      rtc_smart_beacon;
+RTC_DATA_ATTR AirtimeBudget::Retained    rtc_airtime;
+RTC_DATA_ATTR GpsAiding::Retained        rtc_aiding;
+RTC_DATA_ATTR EnergyStats::Retained      rtc_energy;
+RTC_DATA_ATTR CpuClock::Retained         rtc_cpu;
+RTC_DATA_ATTR ListenBeforeTalk::Retained rtc_lbt;
+RTC_DATA_ATTR PositionBatch::Retained    rtc_batch;
+RTC_DATA_ATTR PositionFilter::Retained   rtc_filter;
+RTC_DATA_ATTR EnergyGovernor::Retained   rtc_governor;
+RTC_DATA_ATTR Sensor::Retained           rtc_sensor;
+RTC_DATA_ATTR Geofence::Retained         rtc_geofence;
+RTC_DATA_ATTR TrackLog::Retained         rtc_track;
+
+void resume();
+void enter_deep_sleep(uint32_t sleep_s);
+void light_sleep(uint64_t time_us);
 void setup_gps();
+bool gps_configure();
+void gps_sleep(uint32_t sleep_s);
+void gps_wake();
 void load_config();
 void setup_lora();
+void print_airtime_prediction();
+void apply_profile();
+uint32_t longest_time_on_air_us();
+bool slot_beacon();
+uint32_t slot_lead_ms();
+uint32_t slot_sleep_s();
+bool batching();
+void handle_console();
+void export_track();
+void transmit(const FrameBuilder &frame, uint32_t time_on_air);
+void send_telemetry();
 
-String create_lat_aprs(RawDegrees lat);
-String create_long_aprs(RawDegrees lng);
-String createDateString(time_t t);
-String createTimeString(time_t t);
-String padding(unsigned int number, unsigned int width);
+void append_date_time(FrameBuilder &text, time_t t);
 
 void setup() {
   Serial.begin(115200);
   Wire.begin(SDA, SCL);
   powerManagement.begin(Wire);
+  WiFi.mode(WIFI_OFF);
+  btStop();
+  bootTrace.mark("axp");
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED) {
+    resume();
+    bootTrace.mark("ready");
+    bootTrace.print(Serial);
+    return;
+  }
+  // the receiver searches while the rest comes up, its first sentences wait
+  // in the UART buffer
+  powerManagement.activateGPS();
+  ss.setRxBufferSize(1024);
+  ss.begin(9600, SERIAL_8N1, GPS_TX, GPS_RX);
+  bootTrace.mark("gps power");
   powerManagement.activateLoRa();
   powerManagement.activateOLED();
-  powerManagement.activateGPS();
   powerManagement.activateMeasurement();
-  WiFi.mode(WIFI_OFF);
-  btStop();
-  setup_display();
   load_config();
+  governor.begin(mConfig);
+  geofence.begin(mConfig);
+  trackLog.begin(mConfig.track);
+  cpuClock.begin(mConfig.cpu.low_mhz, mConfig.cpu.high_mhz);
+  smartBeacon.begin(mConfig.beacon.smart_beacon);
+  positionBatch.begin(mConfig.beacon.batch_interval > 0 ? mConfig.beacon.batch_size : 0);
+  positionFilter.begin(mConfig.beacon);
+  if (mConfig.telemetry.active && !sensor.begin(mConfig.telemetry)) {
+    Serial.println("BMP280 not found, no telemetry");
+  }
+  sensor.sample();
+  bootTrace.mark("config");
   setup_gps();
+  gpsTask.begin();
+  bootTrace.mark("gps setup");
+  setup_display();
+  bootTrace.mark("display");
   setup_lora();
+  bootTrace.mark("lora");
+  print_airtime_prediction();
+  beaconSlot.begin(mConfig.beacon.callsign, mConfig.beacon.smart_beacon.slow_rate, longest_time_on_air_us());
+  if (mConfig.beacon.slotted) {
+    beaconSlot.print(Serial);
+  }
   powerManagement.clearCoulomb(); // Todo get when on usb stop charging for clear
+  if (governor.update()) {
+    apply_profile();
+  }
   pinMode(BUTTON_PIN, INPUT_PULLUP);
   pinMode(RED_LED, OUTPUT_OPEN_DRAIN); // Led rouge io4 et Vcc
   digitalWrite(RED_LED, LOW);          // LedON
@@ -55,31 +162,71 @@ void setup() {
   esp_sleep_enable_gpio_wakeup();
   esp_sleep_enable_timer_wakeup(mConfig.beacon.smart_beacon.slow_rate * 1000000);
   String sM = String("Beacon period: ") + String(mConfig.beacon.smart_beacon.slow_rate, DEC) + String("s");
-  show_display("GO...", "", sM, "wait for position...", 1000);
+  show_display("GO...", "", sM.c_str(), "wait for position...");
+  energyStats.begin(EnergyStats::PhaseAcquire);
+  bootTrace.mark("ready");
+  bootTrace.print(Serial);
+  cpuClock.low();
 }
 
 void loop() {
-  static unsigned int rate_limit_message_text = 0;
-  String              batteryVoltage          = "";
-  String              batteryChargeCurrent    = "";
-  String              batteryCoulomb          = "";
-  static int          iState;
-  static int          iDispSte;
+  static int           iDispSte;
+  static unsigned long acquisition_start;
+  static bool          button_beacon;
 
+  handle_console();
   switch (iState) {
     case HasSynchGPS:
       {
-        while (ss.available() > 0) {
-          char c = ss.read();
-          gps.encode(c);
-        }
-        if ((gps.time.isValid()) && (gps.time.age() < 2)) { // plus recent que 10s
-          setTime(gps.time.hour(), gps.time.minute(), gps.time.second(), gps.date.day(), gps.date.month(), gps.date.year());
-          if (gps.location.isValid() && (gps.location.age() < 2)) {
+        // the fix is looked at once RMC and GGA of a burst are both in, the
+        // receiver sends empty RMC without a date before its first fix
+        bool burst = gpsTask.receive(gpsFix);
+        if (burst && gpsFix.time_valid) {
+          setTime(gpsFix.hour, gpsFix.minute, gpsFix.second, gpsFix.day, gpsFix.month, gpsFix.year);
+          beaconSlot.sync(now(), gpsFix.epoch_ms);
+          if (gpsAiding.pending()) {
+            gpsTask.hold();
+            gpsAiding.replay(now());
+            gpsTask.release();
+          }
+          // an outlier waits for the next burst
+          if (gpsFix.location_fresh && positionFilter.update(gpsFix)) {
 #ifdef Debug
             Serial.println("GPS data ok");
 #endif
+            acquisition_failures = 0;
+            no_fix               = false;
+            energyStats.acquired(millis() - acquisition_start);
+            if (geofence.update(gpsFix.lat_deg, gpsFix.lng_deg)) {
+              apply_profile();
+            }
+            // with the smart beacon off it still tells when slow_rate is up
+            // since the last beacon, as speed 0 only sees slow_rate
+            bool due = true;
+            if (mConfig.beacon.smart_beacon.active) {
+              due = smartBeacon.due(millis(), (int)gpsFix.speed_kmph, (int)gpsFix.course_deg);
+            } else if (mConfig.beacon.batch_interval > 0) {
+              due = smartBeacon.due(millis(), 0, (int)gpsFix.course_deg);
+            }
+            positionBatch.add(now(), gpsFix.lat_deg, gpsFix.lng_deg);
+            trackLog.add(now(), gpsFix.lat_deg, gpsFix.lng_deg, gpsFix.altitude_m, gpsFix.speed_kmph);
+            if (due || slot_beacon()) {
+              iState = PrepBeacon;
+            } else {
+              iState = Sleep;
+            }
+          }
+        }
+        // give up on the fix after beacon.timeout, the sleep that follows
+        // doubles with each failure in a row
+        if (iState == HasSynchGPS && mConfig.beacon.timeout > 0 && millis() - acquisition_start > mConfig.beacon.timeout * 60000UL) {
+          Serial.println("No GPS fix");
+          acquisition_failures++;
+          no_fix = true;
+          if (mConfig.beacon.timeout_action == Configuration::Beacon::TimeoutStatus || (mConfig.beacon.timeout_action == Configuration::Beacon::TimeoutLastPosition && gpsFix.location_valid)) {
             iState = PrepBeacon;
+          } else {
+            iState = Sleep;
           }
         }
         if (powerManagement.isCharging()) {
@@ -87,68 +234,111 @@ void loop() {
         } else {
           powerManagement.disableChgLed();
         }
-        delay(10);
+        // nothing comes from the receiver until its next burst
+        uint32_t quiet_ms = NmeaReader::quiet_ms(gpsFix.epoch_ms, millis());
+        if (burst && iState == HasSynchGPS && quiet_ms > 20) {
+          light_sleep((uint64_t)quiet_ms * 1000);
+        } else {
+          delay(10);
+        }
         break;
       }
 
     case PrepBeacon:
       {
+        // a beacon on the fixed period goes at the start of its slot, when
+        // that is too far off it sleeps until the next one
+        if (slot_beacon() && !button_beacon) {
+          uint32_t wait_ms = beaconSlot.wait_ms(millis());
+          if (wait_ms > slot_lead_ms()) {
+            iState = Sleep;
+            break;
+          }
+          if (wait_ms > 0) {
+            light_sleep((uint64_t)wait_ms * 1000);
+          }
+        }
+        // a parked tracker does not send the same position again, the
+        // period starts over as if it had
+        if (!button_beacon && !no_fix && positionFilter.suppress()) {
+          smartBeacon.sent(millis(), (int)gpsFix.course_deg);
+          iState = Sleep;
+          break;
+        }
+        cpuClock.high();
+        energyStats.enter(EnergyStats::PhaseBuild);
+        char         sVBat[12];
+        char         sCoulomb[16];
+        FrameBuilder batteryVoltage(sVBat, sizeof(sVBat));
+        FrameBuilder batteryCoulomb(sCoulomb, sizeof(sCoulomb));
         if (powerManagement.isBatteryConnect()) {
-          batteryVoltage       = String(powerManagement.getBatteryVoltage(), 2) + "V";
-          batteryChargeCurrent = String(powerManagement.getBatteryChargeDischargeCurrent(), 0) + "mA";
-          batteryCoulomb       = String(powerManagement.getBatteryCoulomb(), 2) + "mAH";
+          batteryVoltage.appendFixed(lround(powerManagement.getBatteryVoltage() * 100.0), 2).append('V');
+          batteryCoulomb.appendFixed(lround(powerManagement.getBatteryCoulomb() * 100.0), 2).append("mAH");
         }
-        char sFrame[255] = {
-          '<',
-          0xFF,
-          0x01,
-          0,
-        };
-        strcat(sFrame, mConfig.beacon.callsign.c_str());
-        strcat(sFrame, ">");
-        strcat(sFrame, "APLORA,"); // todo case path empty
-        strcat(sFrame, mConfig.beacon.path.c_str());
-        strcat(sFrame, ":!");
-        strcat(sFrame, create_lat_aprs(gps.location.rawLat()).c_str());
-        strcat(sFrame, mConfig.beacon.overlay.c_str());
-        strcat(sFrame, create_long_aprs(gps.location.rawLng()).c_str());
-        strcat(sFrame, mConfig.beacon.symbol.c_str());
-        int course_int = max(0, min(360, (int)gps.course.deg()));
-        if (course_int <= 0) {
-          course_int += 360;
+        bool charging = powerManagement.isCharging();
+
+        // drop the comment, then the battery voltage, when the frame is too
+        // long or does not fit the airtime left in the last hour
+        char         sFrame[255];
+        FrameBuilder frame(sFrame, sizeof(sFrame));
+        bool         with_message = !(rate_limit_message_text++ % 4); // Comment rate one every N beacon
+        const char  *battery      = charging ? NULL : sVBat;
+        size_t       history      = positionBatch.count();
+        uint32_t     time_on_air;
+        while (true) {
+          if (no_fix && mConfig.beacon.timeout_action == Configuration::Beacon::TimeoutStatus) {
+            build_status_frame(frame, mConfig.beacon, battery);
+          } else {
+            build_position_frame(frame, mConfig.beacon, gpsFix, positionBatch, with_message, battery, history);
+          }
+          time_on_air = lora_time_on_air_us(mConfig.lora, frame.length());
+          if (!frame.overflow() && airtimeBudget.allows(time_on_air)) {
+            break;
+          }
+          if (with_message) {
+            with_message = false;
+          } else if (battery) {
+            battery = NULL;
+          } else if (history > 0) {
+            history /= 2;
+          } else {
+            break;
+          }
         }
-        strcat(sFrame, padding(course_int, 3).c_str());
-        strcat(sFrame, "/");
-        int speed_int = max(0, min(999, (int)gps.speed.knots()));
-        strcat(sFrame, padding(speed_int, 3).c_str());
-
-        int alt_int = max(-99999, min(999999, (int)gps.altitude.feet()));
-        if (alt_int < 0) {
-          strcat(sFrame, "/A=-");
-          strcat(sFrame, padding(alt_int * -1, 5).c_str());
+
+        char         sDateTime[24];
+        char         sSats[32];
+        char         sBattery[32];
+        FrameBuilder dateTime(sDateTime, sizeof(sDateTime));
+        FrameBuilder sats(sSats, sizeof(sSats));
+        FrameBuilder batteryLine(sBattery, sizeof(sBattery));
+        append_date_time(dateTime, now());
+        sats.append("Sats: ").appendNumber(gpsFix.satellites).append(" HDOP: ").appendFixed(gpsFix.hdop, 2);
+        if (charging) {
+          batteryLine.append("Powered via USB");
         } else {
-          strcat(sFrame, "/A=");
-          strcat(sFrame, padding(alt_int, 6).c_str());
+          batteryLine.append("Bat:").append(sVBat).append(", ").append(sCoulomb);
         }
-        if (!(rate_limit_message_text++ % 4)) { // Comment rate one every N beacon
-          strcat(sFrame, mConfig.beacon.message.c_str());
+        show_display(mConfig.beacon.callsign.c_str(), sDateTime, sSats, sBattery);
+        if (frame.overflow() || !airtimeBudget.allows(time_on_air)) {
+          Serial.println(frame.overflow() ? "Frame too long, not sent" : "Airtime budget used up, not sent");
+          LoRa.sleep();
+          iState = Sleep;
+          break;
         }
-        if (!powerManagement.isCharging()) {
-          strcat(sFrame, "VBat= ");
-          strcat(sFrame, batteryVoltage.c_str());
+        transmit(frame, time_on_air);
+        positionBatch.clear();
+        positionFilter.sent();
+        if (bootTrace.firstBeacon()) {
+          Serial.printf("First beacon %lu ms after boot\n", bootTrace.firstBeacon_ms());
         }
-        show_display(mConfig.beacon.callsign, createDateString(now()) + "   " + createTimeString(now()), String("Sats: ") + gps.satellites.value() + " HDOP: " + gps.hdop.hdop(), !powerManagement.isCharging() ? (String("Bat:") + batteryVoltage + ", " + batteryCoulomb) : "Powered via USB", 100);
-        if (mConfig.ptt.active) {
-          digitalWrite(mConfig.ptt.io_pin, mConfig.ptt.reverse ? LOW : HIGH);
-          delay(mConfig.ptt.start_delay);
-        } // fin formation Frame
-
-        LoRa.beginPacket();
-        LoRa.write((const uint8_t *)sFrame, strlen(sFrame));
-        LoRa.endPacket();
-        if (mConfig.ptt.active) {
-          delay(mConfig.ptt.end_delay);
-          digitalWrite(mConfig.ptt.io_pin, mConfig.ptt.reverse ? HIGH : LOW);
+        smartBeacon.sent(millis(), (int)gpsFix.course_deg);
+        energyStats.beacon();
+        // the weather goes at its own, slower rate, after a beacon
+        if (sensor.due(millis()) && timeStatus() != timeNotSet) {
+          energyStats.enter(EnergyStats::PhaseBuild);
+          cpuClock.high();
+          send_telemetry();
         }
         LoRa.sleep();
         iState = Sleep;
@@ -156,33 +346,93 @@ void loop() {
       }
     case Sleep:
       {
-        powerManagement.deactivateGPS();
+        energyStats.enter(EnergyStats::PhaseSleep);
+        cpuClock.low();
+        if (governor.update()) {
+          apply_profile();
+        }
+        // while moving the GPS stays on to follow the course between beacons
+        uint32_t sleep_s = mConfig.beacon.smart_beacon.slow_rate;
+        if (mConfig.beacon.smart_beacon.active || batching()) {
+          sleep_s = smartBeacon.nextWake_s(millis());
+        }
+        if (batching()) {
+          sleep_s = min(sleep_s, (uint32_t)mConfig.beacon.batch_interval);
+        }
+        if (acquisition_failures > 0) {
+          uint32_t backoff = 1UL << min(acquisition_failures - 1, 16U);
+          sleep_s *= min(backoff, (uint32_t)max(1, mConfig.beacon.max_backoff));
+        }
+        if (slot_beacon()) {
+          sleep_s = slot_sleep_s();
+        }
+        if (no_fix || !mConfig.beacon.smart_beacon.active || !smartBeacon.moving()) {
+          gps_sleep(sleep_s);
+        }
         if (iDispSte != 0) { // sinon display passe off trop vite
           iDispSte = 0;
-          delay(4000);
+          display_keep(4000);
+        }
+        // the panel stays readable a moment, the CPU sleeps meanwhile
+        uint32_t shown_ms = display_remaining_ms(millis());
+        if (shown_ms > 0) {
+          light_sleep((uint64_t)shown_ms * 1000);
         }
         display_off();
+        if (slot_beacon()) {
+          sleep_s = slot_sleep_s();
+        }
+        button_beacon = false;
 #ifdef Debug
         Serial.flush();
 #endif
         digitalWrite(RED_LED, HIGH); // LedOFF
-        esp_light_sleep_start();
-        if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO) {
-          show_display("AWAKE", "   ", "wait for position...", 100);
-          display_on();
-          iDispSte = 1;
+        iState = WakeUp;
+        if (mConfig.deep_sleep) {
+          enter_deep_sleep(sleep_s);
         }
-        powerManagement.activateGPS();
+        light_sleep((uint64_t)sleep_s * 1000000);
+        break;
+      }
+
+    case WakeUp:
+      {
+        governor.rested(millis());
+        esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+        if (cause == ESP_SLEEP_WAKEUP_GPIO || cause == ESP_SLEEP_WAKEUP_EXT0) {
+          smartBeacon.trigger();
+          button_beacon = true;
+          if (governor.display()) {
+            cpuClock.high();
+            display_on();
+            show_display("AWAKE", "", "wait for position...");
+            cpuClock.low();
+            iDispSte = 1;
+          }
+        }
+        gpsTask.hold();
+        gps_wake();
+        sensor.sample();
 #ifdef Debug
         Serial.println("awake");
 #endif
-        delay(500); // To get millis() change his value gps.time.age() on the old val
-        iState = HasSynchGPS;
+        // a receiver still booting misses the first UBX messages, the
+        // acknowledgements make gps_configure() send them again
+        if (mConfig.gps.power_mode == Configuration::GPS::PowerOff) {
+          gps_configure();
+          gpsAiding.restore(timeStatus() == timeNotSet ? 0 : now());
+        }
+        gpsTask.release();
+        gpsTask.reset();
+        energyStats.enter(EnergyStats::PhaseAcquire);
+        acquisition_start = millis();
+        iState            = HasSynchGPS;
         break;
       }
 
     default:
-      iState = HasSynchGPS;
+      acquisition_start = millis();
+      iState            = HasSynchGPS;
       break;
   }
 }
@@ -191,12 +441,190 @@ void load_config() {
   ConfigurationManagement confmg("/beacon.json");
   mConfig = confmg.readConfiguration();
   if (mConfig.beacon.callsign == "NOCALL-7") {
+    display_on();
     show_display("ERROR", "You have to change your settings in 'data/tracker.json' and ", "upload it via \"Upload File System image\"!");
     while (true) {
     }
   }
 }
 
+// Wake up from deep sleep: the CPU starts again from setup() with only the RTC
+// memory left, the AXP192, the GPS, the radio and the panel kept their state.
+// A button press ends the sleep at an unknown time, it counts as no time
+// slept and the clock waits for the GPS.
+void resume() {
+  bool     timer    = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+  uint32_t slept_ms = timer ? rtc_sleep_ms : 0;
+  if (!ConfigurationManagement::readImage(mConfig)) {
+    load_config();
+  }
+  bootTrace.mark("config");
+  governor.begin(mConfig);
+  governor.resume(rtc_governor, slept_ms);
+  geofence.begin(mConfig);
+  geofence.resume(rtc_geofence);
+  geofence.apply(mConfig);
+  governor.apply(mConfig);
+  cpuClock.begin(mConfig.cpu.low_mhz, mConfig.cpu.high_mhz);
+  cpuClock.resume(rtc_cpu);
+  lbt.resume(rtc_lbt);
+  if (timer && rtc_time != 0) {
+    setTime(rtc_time + slept_ms / 1000);
+  }
+  smartBeacon.begin(mConfig.beacon.smart_beacon);
+  smartBeacon.resume(rtc_smart_beacon, slept_ms);
+  positionBatch.begin(mConfig.beacon.batch_interval > 0 ? mConfig.beacon.batch_size : 0);
+  positionBatch.resume(rtc_batch);
+  positionFilter.begin(mConfig.beacon);
+  positionFilter.resume(rtc_filter, slept_ms);
+  sensor.begin(mConfig.telemetry);
+  sensor.resume(rtc_sensor, slept_ms);
+  trackLog.begin(mConfig.track);
+  trackLog.resume(rtc_track);
+  gpsAiding.resume(rtc_aiding, slept_ms);
+  energyStats.resume(rtc_energy, slept_ms);
+  bootTrace.mark("resume");
+  ss.setRxBufferSize(1024);
+  ss.begin(gps_baud, SERIAL_8N1, GPS_TX, GPS_RX);
+  gpsTask.begin();
+  bootTrace.mark("gps setup");
+  setup_lora();
+  bootTrace.mark("lora");
+  airtimeBudget.resume(rtc_airtime, slept_ms);
+  beaconSlot.begin(mConfig.beacon.callsign, mConfig.beacon.smart_beacon.slow_rate, longest_time_on_air_us());
+  pinMode(BUTTON_PIN, INPUT_PULLUP);
+  pinMode(RED_LED, OUTPUT_OPEN_DRAIN);
+  digitalWrite(RED_LED, LOW);
+  gpio_wakeup_enable(BUTTON_PIN, GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  cpuClock.low();
+}
+
+// Sleeps until the next beacon with the CPU and its RAM off, loop() goes on
+// with WakeUp from resume(). TinyGPS loses its fix, a beacon sent with the
+// last position after a GPS timeout only has that of the current wake up.
+void enter_deep_sleep(uint32_t sleep_s) {
+  unsigned long now_ms = millis();
+  smartBeacon.retain(rtc_smart_beacon, now_ms);
+  airtimeBudget.retain(rtc_airtime, now_ms);
+  gpsAiding.retain(rtc_aiding, now_ms);
+  energyStats.retain(rtc_energy, now_ms);
+  cpuClock.retain(rtc_cpu);
+  lbt.retain(rtc_lbt);
+  positionBatch.retain(rtc_batch);
+  positionFilter.retain(rtc_filter, now_ms);
+  governor.retain(rtc_governor, now_ms);
+  sensor.retain(rtc_sensor, now_ms);
+  geofence.retain(rtc_geofence);
+  trackLog.retain(rtc_track);
+  rtc_time     = timeStatus() == timeNotSet ? 0 : now();
+  rtc_sleep_ms = sleep_s * 1000;
+  esp_sleep_enable_timer_wakeup((uint64_t)sleep_s * 1000000);
+  esp_sleep_enable_ext0_wakeup((gpio_num_t)BUTTON_PIN, 0);
+  Serial.flush();
+  esp_deep_sleep_start();
+}
+
+// With the comment, the battery voltage and a full batch, the longest
+// position frame.
+uint32_t longest_time_on_air_us() {
+  char         sFrame[255];
+  FrameBuilder frame(sFrame, sizeof(sFrame));
+  build_position_frame(frame, mConfig.beacon, gpsFix, positionBatch, true, "4.20V", 0);
+  return lora_time_on_air_us(mConfig.lora, frame.length() + PositionBatch::encodedLength(positionBatch.size()));
+}
+
+// Beacons on the fixed slow_rate period use their slot once the GPS gave the
+// time. The smart beacon rate while moving, a failed acquisition and the
+// button do not wait for it.
+bool slot_beacon() {
+  return mConfig.beacon.slotted && beaconSlot.synced() && !no_fix && (!mConfig.beacon.smart_beacon.active || !smartBeacon.moving());
+}
+
+// Wake up this long before the slot: the p90 of the last acquisitions, which
+// leaves out the cold start at boot, and 3 s for the UBX set up and the frame.
+uint32_t slot_lead_ms() {
+  return (uint32_t)energyStats.acquisition_ms(90) + 3000;
+}
+
+// Until the wake up for the slot, or for the next fix of the batch before.
+uint32_t slot_sleep_s() {
+  uint32_t sleep_s = beaconSlot.sleep_ms(millis(), slot_lead_ms()) / 1000;
+  if (batching()) {
+    sleep_s = min(sleep_s, (uint32_t)mConfig.beacon.batch_interval);
+  }
+  return sleep_s;
+}
+
+// Fixes are recorded for the next beacon on the fixed slow_rate period, the
+// smart beacon rate while moving sends each of them.
+bool batching() {
+  return mConfig.beacon.batch_interval > 0 && (!mConfig.beacon.smart_beacon.active || !smartBeacon.moving());
+}
+
+// Sends a frame that fits the airtime budget: waits while another station is
+// heard on the channel, keys the PTT output around it and returns once it is
+// on air. The listening counts in the phase of the caller, the transmit phase
+// starts with the frame.
+void transmit(const FrameBuilder &frame, uint32_t time_on_air) {
+  lbt.start();
+  uint32_t backoff_ms;
+  while ((backoff_ms = lbt.busy(time_on_air)) > 0) {
+    light_sleep((uint64_t)backoff_ms * 1000);
+  }
+  if (mConfig.ptt.active) {
+    energyStats.enter(EnergyStats::PhasePtt);
+    digitalWrite(mConfig.ptt.io_pin, mConfig.ptt.reverse ? LOW : HIGH);
+    delay(mConfig.ptt.start_delay);
+  }
+
+  energyStats.enter(EnergyStats::PhaseTransmit);
+  LoRa.beginPacket();
+  LoRa.write((const uint8_t *)frame.c_str(), frame.length());
+  // endPacket() only polls the radio until the end of the transmission
+  cpuClock.low();
+  LoRa.endPacket();
+  airtimeBudget.consume(time_on_air);
+  if (mConfig.ptt.active) {
+    energyStats.enter(EnergyStats::PhasePtt);
+    delay(mConfig.ptt.end_delay);
+    digitalWrite(mConfig.ptt.io_pin, mConfig.ptt.reverse ? HIGH : LOW);
+  }
+}
+
+// The averages of the BMP280 samples since the last report, preceded with the
+// T# scaling messages when they are due. A frame over the airtime budget
+// leaves the rest for after the next beacon.
+void send_telemetry() {
+  char         sFrame[128];
+  FrameBuilder frame(sFrame, sizeof(sFrame));
+  float        battery     = powerManagement.isBatteryConnect() ? powerManagement.getBatteryVoltage() : 0;
+  int          definitions = sensor.definitionsDue() ? Sensor::Definitions : 0;
+  for (int i = 0; i <= definitions; i++) {
+    build_frame_header(frame, mConfig.beacon);
+    if (i < definitions) {
+      sensor.appendDefinition(frame, mConfig.beacon.callsign, i);
+    } else {
+      sensor.appendReport(frame, now(), battery);
+    }
+    uint32_t time_on_air = lora_time_on_air_us(mConfig.lora, frame.length());
+    if (frame.overflow() || !airtimeBudget.allows(time_on_air)) {
+      Serial.println("Telemetry over the airtime budget, not sent");
+      return;
+    }
+    transmit(frame, time_on_air);
+  }
+  sensor.sent(millis());
+}
+
+// Light sleep for time_us, not counted as time at either CPU clock.
+void light_sleep(uint64_t time_us) {
+  esp_sleep_enable_timer_wakeup(time_us);
+  cpuClock.asleep();
+  esp_light_sleep_start();
+  cpuClock.awake();
+}
+
 void setup_lora() {
   SPI.begin(LORA_SCK, LORA_MISO, LORA_MOSI, LORA_CS);
   LoRa.setPins(LORA_CS, LORA_RST, LORA_IRQ);
@@ -208,63 +636,182 @@ void setup_lora() {
   LoRa.setSpreadingFactor(mConfig.lora.spreadingFactor);
   LoRa.setSignalBandwidth(mConfig.lora.signalBandwidth);
   LoRa.setCodingRate4(mConfig.lora.codingRate4);
-  LoRa.enableCrc();
+  LoRa.setPreambleLength(mConfig.lora.preambleLength);
+  if (mConfig.lora.crc) {
+    LoRa.enableCrc();
+  } else {
+    LoRa.disableCrc();
+  }
   LoRa.setTxPower(mConfig.lora.power);
+  lbt.begin(mConfig.lora);
+  airtimeBudget.setBudget(mConfig.lora.dutyCycle * 36000);
 }
 
-void setup_gps() {
-  ss.begin(9600, SERIAL_8N1, GPS_TX, GPS_RX);
+// After a change of profile or zone: the periods, comment, transmit power and
+// spreading factor they set, and what depends on them.
+void apply_profile() {
+  geofence.apply(mConfig);
+  governor.apply(mConfig);
+  governor.print(Serial);
+  geofence.print(Serial);
+  smartBeacon.begin(mConfig.beacon.smart_beacon);
+  LoRa.setTxPower(mConfig.lora.power);
+  LoRa.setSpreadingFactor(mConfig.lora.spreadingFactor);
+  lbt.begin(mConfig.lora);
+  beaconSlot.begin(mConfig.beacon.callsign, mConfig.beacon.smart_beacon.slow_rate, longest_time_on_air_us());
 }
 
-char *s_min_nn(uint32_t min_nnnnn, int precision) {
-  static char buf[8];
-  double      dMin = min_nnnnn * 6e-8;
-  sprintf(buf, "%07.4f", dMin);
-  for (int it = (3 + precision); it < 5; it++)
-    buf[it] = '0';
-  buf[5] = 0;
-  return buf;
+// Frames have a fixed length for a given configuration, so a frame built
+// before the first fix tells the airtime of every beacon.
+void print_airtime_prediction() {
+  char         sFrame[255];
+  FrameBuilder frame(sFrame, sizeof(sFrame));
+  build_position_frame(frame, mConfig.beacon, gpsFix, positionBatch, true, "4.20V", 0);
+  uint32_t time_on_air = lora_time_on_air_us(mConfig.lora, frame.length());
+  Serial.printf("Airtime per beacon: %u ms for %u bytes, %.3f mAh", (unsigned)(time_on_air / 1000), (unsigned)frame.length(), lora_tx_charge_mAh(mConfig.lora, time_on_air));
+  if (positionBatch.size() > 0) {
+    size_t length = frame.length() + PositionBatch::encodedLength(positionBatch.size());
+    Serial.printf(", %u ms for %u bytes with %u batched fixes", (unsigned)(longest_time_on_air_us() / 1000), (unsigned)length, (unsigned)positionBatch.size());
+  }
+  if (mConfig.lora.dutyCycle > 0) {
+    Serial.printf(", budget %u ms per hour", (unsigned)(mConfig.lora.dutyCycle * 36000));
+  }
+  Serial.println();
 }
 
-String create_lat_aprs(RawDegrees lat) {
-  char str[20];
-  char n_s = 'N';
-  if (lat.negative) {
-    n_s = 'S';
+// Commands typed on the console, one per line.
+void handle_console() {
+  static char   line[32];
+  static size_t length;
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (length < sizeof(line) - 1) {
+        line[length++] = c;
+      }
+      continue;
+    }
+    line[length] = '\0';
+    length       = 0;
+    if (!strcmp(line, "stats")) {
+      energyStats.print(Serial);
+      cpuClock.print(Serial);
+      lbt.print(Serial);
+      positionFilter.print(Serial);
+      governor.print(Serial);
+      geofence.print(Serial);
+      trackLog.print(Serial);
+      Serial.printf("GPS bursts dropped %u\n", (unsigned)gpsTask.dropped());
+    } else if (!strcmp(line, "stats reset")) {
+      energyStats.reset();
+      cpuClock.reset();
+      lbt.reset();
+      positionFilter.reset();
+    } else if (!strcmp(line, "track")) {
+      export_track();
+    } else if (line[0]) {
+      Serial.println("commands: stats, stats reset, track");
+    }
   }
-  sprintf(str, "%02d%s%c", lat.deg, s_min_nn(lat.billionths, mConfig.beacon.positiondilution), n_s);
-  String lat_str(str);
-  return lat_str;
 }
 
-String create_long_aprs(RawDegrees lng) {
-  char str[20];
-  char e_w = 'E';
-  if (lng.negative) {
-    e_w = 'W';
-  }
-  sprintf(str, "%03d%s%c", lng.deg, s_min_nn(lng.billionths, mConfig.beacon.positiondilution), e_w);
-  String lng_str(str);
-  return lng_str;
+// The size at the console rate, then the track log pages in binary at
+// TrackExportBaud for tools/track_export.py, which switches on the size line.
+void export_track() {
+  static const unsigned long TrackExportBaud = 921600;
+  Serial.printf("TRACK %u %lu\n", (unsigned)trackLog.exportSize(), TrackExportBaud);
+  Serial.flush();
+  Serial.updateBaudRate(TrackExportBaud);
+  delay(100);
+  trackLog.exportTo(Serial);
+  Serial.flush();
+  delay(100);
+  Serial.updateBaudRate(115200);
 }
 
-String createDateString(time_t t) {
-  return String(padding(day(t), 2) + "." + padding(month(t), 2) + "." + padding(year(t), 4));
+// The UART is already open at 9600 baud since the receiver's power-up.
+void setup_gps() {
+  if (!gps_configure()) {
+    Serial.println("GPS configuration not acknowledged");
+  }
+  if (mConfig.gps.power_mode == Configuration::GPS::PowerCyclic) {
+    // the receiver may still be booting right after power-on
+    for (int i = 0; i < 3; i++) {
+      if (ubx.setCyclic(mConfig.gps.update_period * 1000UL)) {
+        return;
+      }
+    }
+    Serial.println("GPS power save not acknowledged");
+    return;
+  }
+  // the backup battery keeps the power save mode of an earlier power_mode
+  // "cyclic" over a power cycle
+  if (!ubx.setContinuous()) {
+    Serial.println("GPS full power not acknowledged");
+  }
+  if (mConfig.gps.power_mode == Configuration::GPS::PowerOff) {
+    // no time yet after a reboot, the ephemerides wait for the first time
+    // from the receiver to check their age
+    gpsAiding.restore(0);
+  }
 }
 
-String createTimeString(time_t t) {
-  return String(padding(hour(t), 2) + ":" + padding(minute(t), 2) + ":" + padding(second(t), 2));
+// After each power-up the receiver talks at 9600 baud with every NMEA
+// sentence enabled. It is moved to gps.baud and only RMC and GGA are kept, a
+// receiver that already runs at gps.baud ignores the 9600 baud part.
+bool gps_configure() {
+  static const uint8_t unused[] = {UBX_NMEA_GLL, UBX_NMEA_GSA, UBX_NMEA_GSV, UBX_NMEA_VTG};
+  for (int attempt = 0; attempt < 3; attempt++) {
+    ss.updateBaudRate(9600);
+    if (mConfig.gps.baud != 9600) {
+      ubx.setBaudRate(mConfig.gps.baud);
+      ss.updateBaudRate(mConfig.gps.baud);
+    }
+    bool acknowledged = true;
+    for (size_t i = 0; i < sizeof(unused) && acknowledged; i++) {
+      acknowledged = ubx.setNmeaRate(unused[i], 0);
+    }
+    if (acknowledged) {
+      gps_baud = mConfig.gps.baud;
+      return true;
+    }
+  }
+  ss.updateBaudRate(9600);
+  gps_baud = 9600;
+  return false;
 }
 
-String padding(unsigned int number, unsigned int width) {
-  String result;
-  String num(number);
-  if (num.length() > width) {
-    width = num.length();
+// Off cuts LDO3 and the next fix is a warm start, backup and cyclic keep the
+// receiver powered so that it keeps its ephemeris and comes back hot.
+void gps_sleep(uint32_t sleep_s) {
+  gpsTask.hold();
+  switch (mConfig.gps.power_mode) {
+    case Configuration::GPS::PowerBackup:
+      ubx.backup(sleep_s * 1000UL);
+      break;
+    case Configuration::GPS::PowerCyclic:
+      // the receiver duty-cycles itself
+      break;
+    default:
+      if (gpsFix.location_valid) {
+        gpsAiding.setPosition(lround(gpsFix.lat_deg * 1e7), lround(gpsFix.lng_deg * 1e7), lround(gpsFix.altitude_m * 100));
+        gpsAiding.save(millis(), timeStatus() == timeNotSet ? 0 : now());
+      }
+      powerManagement.deactivateGPS();
+      break;
   }
-  for (unsigned int i = 0; i < width - num.length(); i++) {
-    result.concat('0');
+  gpsTask.release();
+}
+
+void gps_wake() {
+  powerManagement.activateGPS();
+  if (mConfig.gps.power_mode == Configuration::GPS::PowerBackup) {
+    ubx.wake();
   }
-  result.concat(num);
-  return result;
+}
+
+void append_date_time(FrameBuilder &text, time_t t) {
+  text.appendNumber(day(t), 2).append('.').appendNumber(month(t), 2).append('.').appendNumber(year(t), 4);
+  text.append("   ");
+  text.appendNumber(hour(t), 2).append(':').appendNumber(minute(t), 2).append(':').appendNumber(second(t), 2);
 }
@@ -0,0 +1,77 @@
+#include "airtime.h"
+
+// cppcheck-suppress unusedFunction
+uint32_t lora_time_on_air_us(const Configuration::LoRa &lora, size_t payload_length) {
+  int  sf              = lora.spreadingFactor;
+  long symbol_duration = 1000 / (lora.signalBandwidth / (1L << sf));
+  int  de              = symbol_duration > 16 ? 1 : 0;
+
+  long numerator   = 8L * payload_length - 4 * sf + 28 + (lora.crc ? 16 : 0);
+  long denominator = 4L * (sf - 2 * de);
+  long payload     = 8;
+  if (numerator > 0) {
+    payload += (numerator + denominator - 1) / denominator * lora.codingRate4;
+  }
+  // in quarter symbols, the preamble lasts n + 4.25 symbols
+  uint64_t quarters = 4ULL * lora.preambleLength + 17 + 4ULL * payload;
+  return (uint32_t)(quarters * (1000000ULL << sf) / (4ULL * lora.signalBandwidth));
+}
+
+// cppcheck-suppress unusedFunction
+double lora_tx_charge_mAh(const Configuration::LoRa &lora, uint32_t time_on_air_us) {
+  return lora.txCurrent * (time_on_air_us / 3.6e9);
+}
+
+AirtimeBudget::AirtimeBudget() : mBudget_ms(0), mSlot(0), mSlotStart(0) {
+  memset(mSlot_ms, 0, sizeof(mSlot_ms));
+}
+
+void AirtimeBudget::setBudget(uint32_t budget_ms_per_hour) {
+  mBudget_ms = budget_ms_per_hour;
+}
+
+void AirtimeBudget::expire() {
+  unsigned long now = millis();
+  while (now - mSlotStart >= Slot_ms) {
+    mSlotStart += Slot_ms;
+    mSlot           = (mSlot + 1) % Slots;
+    mSlot_ms[mSlot] = 0;
+    if (now - mSlotStart >= Slots * Slot_ms) {
+      memset(mSlot_ms, 0, sizeof(mSlot_ms));
+      mSlotStart = now;
+    }
+  }
+}
+
+uint32_t AirtimeBudget::used_ms() {
+  expire();
+  uint32_t used = 0;
+  for (int i = 0; i < Slots; i++) {
+    used += mSlot_ms[i];
+  }
+  return used;
+}
+
+// A budget of 0 means unlimited.
+bool AirtimeBudget::allows(uint32_t time_on_air_us) {
+  return mBudget_ms == 0 || used_ms() + (time_on_air_us + 999) / 1000 <= mBudget_ms;
+}
+
+void AirtimeBudget::consume(uint32_t time_on_air_us) {
+  expire();
+  mSlot_ms[mSlot] += (time_on_air_us + 999) / 1000;
+}
+
+// cppcheck-suppress unusedFunction
+void AirtimeBudget::retain(Retained &retained, unsigned long now_ms) const {
+  memcpy(retained.slot_ms, mSlot_ms, sizeof(mSlot_ms));
+  retained.slot        = mSlot;
+  retained.slot_age_ms = now_ms - mSlotStart;
+}
+
+// cppcheck-suppress unusedFunction
+void AirtimeBudget::resume(const Retained &retained, uint32_t slept_ms) {
+  memcpy(mSlot_ms, retained.slot_ms, sizeof(mSlot_ms));
+  mSlot      = retained.slot;
+  mSlotStart = 0UL - (retained.slot_age_ms + slept_ms);
+}
@@ -0,0 +1,48 @@
+#ifndef AIRTIME_H_
+#define AIRTIME_H_
+
+#include <Arduino.h>
+
+#include "configuration.h"
+
+// Time on air of an explicit header packet, SX1276/77/78 datasheet 4.1.1.7,
+// with low data rate optimization switched on like the LoRa library does.
+uint32_t lora_time_on_air_us(const Configuration::LoRa &lora, size_t payload_length);
+// Charge drawn by the PA for one transmission of that length.
+double lora_tx_charge_mAh(const Configuration::LoRa &lora, uint32_t time_on_air_us);
+
+// Airtime spent over the last hour, kept in 5 minute slots.
+class AirtimeBudget {
+public:
+  AirtimeBudget();
+
+  void     setBudget(uint32_t budget_ms_per_hour);
+  bool     allows(uint32_t time_on_air_us);
+  void     consume(uint32_t time_on_air_us);
+  uint32_t used_ms();
+
+private:
+  static const int           Slots   = 12;
+  static const unsigned long Slot_ms = 300000;
+
+public:
+  // The slots as kept over a deep sleep, see SmartBeacon::Retained.
+  struct Retained {
+    uint32_t slot_ms[Slots];
+    int      slot;
+    uint32_t slot_age_ms;
+  };
+  void retain(Retained &retained, unsigned long now_ms) const;
+  void resume(const Retained &retained, uint32_t slept_ms);
+
+private:
+
+  void expire();
+
+  uint32_t      mBudget_ms;
+  uint32_t      mSlot_ms[Slots];
+  int           mSlot;
+  unsigned long mSlotStart;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "beacon_frame.h"
+
+void build_position_frame(FrameBuilder &frame, const Configuration::Beacon &beacon, const GpsFix &fix, const PositionBatch &batch, bool with_message, const char *battery, size_t history) {
+  char table  = beacon.overlay.length() ? beacon.overlay[0] : '/';
+  char symbol = beacon.symbol.length() ? beacon.symbol[0] : '[';
+
+  int course_int = max(0, min(360, (int)fix.course_deg));
+  if (course_int <= 0) {
+    course_int += 360;
+  }
+  int speed_int = max(0, min(999, (int)fix.speed_knots));
+
+  frame.reset();
+  frame.append('<').append((char)0xFF).append((char)0x01);
+  frame.append(beacon.callsign).append('>');
+  switch (beacon.format) {
+    case Configuration::Beacon::Compressed:
+      frame.append("APLORA,").append(beacon.path).append(":!");
+      frame.appendCompressedPosition(fix.lat, fix.lng, table, symbol, course_int, fix.speed_knots);
+      break;
+
+    case Configuration::Beacon::MicE:
+      frame.appendMicEDestination(fix.lat, fix.lng, beacon.positiondilution);
+      frame.append(',').append(beacon.path).append(':');
+      frame.appendMicEPosition(fix.lng, beacon.positiondilution, table, symbol, course_int, speed_int, lround(fix.altitude_m));
+      break;
+
+    default:
+      {
+        frame.append("APLORA,"); // todo case path empty
+        frame.append(beacon.path).append(":!");
+        frame.appendLatitude(fix.lat, beacon.positiondilution);
+        frame.append(beacon.overlay);
+        frame.appendLongitude(fix.lng, beacon.positiondilution);
+        frame.append(beacon.symbol);
+        frame.appendNumber(course_int, 3).append('/');
+        frame.appendNumber(speed_int, 3);
+
+        int alt_int = max(-99999, min(999999, (int)(fix.altitude_m * _GPS_FEET_PER_METER)));
+        if (alt_int < 0) {
+          frame.append("/A=-").appendNumber(alt_int * -1, 5);
+        } else {
+          frame.append("/A=").appendNumber(alt_int, 6);
+        }
+        break;
+      }
+  }
+  batch.append(frame, history);
+  if (with_message) {
+    frame.append(beacon.message);
+  }
+  if (battery) {
+    frame.append("VBat= ").append(battery);
+  }
+}
+
+void build_status_frame(FrameBuilder &frame, const Configuration::Beacon &beacon, const char *battery) {
+  build_frame_header(frame, beacon);
+  frame.append(">No GPS fix");
+  if (battery) {
+    frame.append(" VBat= ").append(battery);
+  }
+}
+
+void build_frame_header(FrameBuilder &frame, const Configuration::Beacon &beacon) {
+  frame.reset();
+  frame.append('<').append((char)0xFF).append((char)0x01);
+  frame.append(beacon.callsign).append('>');
+  frame.append("APLORA,").append(beacon.path).append(':');
+}
@@ -0,0 +1,20 @@
+#ifndef BEACON_FRAME_H_
+#define BEACON_FRAME_H_
+
+#include <Arduino.h>
+
+#include "configuration.h"
+#include "frame_builder.h"
+#include "gps_task.h"
+#include "position_batch.h"
+
+// Position report of fix, battery is the "VBat= " text or NULL when it is
+// left out, followed by up to history fixes of batch.
+// frame.overflow() tells when it does not fit the buffer.
+void build_position_frame(FrameBuilder &frame, const Configuration::Beacon &beacon, const GpsFix &fix, const PositionBatch &batch, bool with_message, const char *battery, size_t history);
+// Status report sent instead of the position when the GPS has no fix.
+void build_status_frame(FrameBuilder &frame, const Configuration::Beacon &beacon, const char *battery);
+// The LoRa APRS prefix and the addresses, up to the information field.
+void build_frame_header(FrameBuilder &frame, const Configuration::Beacon &beacon);
+
+#endif
@@ -0,0 +1,64 @@
+#include "beacon_slot.h"
+
+// FNV-1a, spreads callsigns that differ only in the SSID
+static uint32_t callsign_hash(const String &callsign) {
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < callsign.length(); i++) {
+    hash ^= (uint8_t)callsign[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+BeaconSlot::BeaconSlot() : mPeriod_ms(0), mSlot_ms(0), mSlots(1), mSlot(0), mTimeOnAir_ms(0), mSynced(false), mUtc_ms(0), mAt_ms(0) {
+}
+
+// cppcheck-suppress unusedFunction
+void BeaconSlot::begin(const String &callsign, uint32_t period_s, uint32_t time_on_air_us) {
+  mTimeOnAir_ms = (time_on_air_us + 999) / 1000;
+  mSlot_ms      = (mTimeOnAir_ms + Guard_ms + 999) / 1000 * 1000;
+  mPeriod_ms    = max(period_s * 1000, mSlot_ms);
+  mSlots        = mPeriod_ms / mSlot_ms;
+  mSlot         = callsign_hash(callsign) % mSlots;
+}
+
+// cppcheck-suppress unusedFunction
+void BeaconSlot::sync(time_t utc, unsigned long at_ms) {
+  mUtc_ms = (uint64_t)utc * 1000;
+  mAt_ms  = at_ms;
+  mSynced = true;
+}
+
+// cppcheck-suppress unusedFunction
+bool BeaconSlot::synced() const {
+  return mSynced;
+}
+
+uint32_t BeaconSlot::sinceStart_ms(unsigned long now_ms) const {
+  uint64_t utc_ms = mUtc_ms + (now_ms - mAt_ms);
+  return (uint32_t)((utc_ms + mPeriod_ms - (uint64_t)mSlot * mSlot_ms) % mPeriod_ms);
+}
+
+// cppcheck-suppress unusedFunction
+uint32_t BeaconSlot::wait_ms(unsigned long now_ms) const {
+  uint32_t since = sinceStart_ms(now_ms);
+  // a late start may use half of the guard
+  if (since + mTimeOnAir_ms + Guard_ms / 2 <= mSlot_ms) {
+    return 0;
+  }
+  return mPeriod_ms - since;
+}
+
+// cppcheck-suppress unusedFunction
+uint32_t BeaconSlot::sleep_ms(unsigned long now_ms, uint32_t lead_ms) const {
+  uint32_t next = mPeriod_ms - sinceStart_ms(now_ms);
+  while (next < lead_ms + 1000) {
+    next += mPeriod_ms;
+  }
+  return next - lead_ms;
+}
+
+// cppcheck-suppress unusedFunction
+void BeaconSlot::print(Print &out) const {
+  out.printf("Beacon slot %u of %u, %u ms every %u s\n", (unsigned)mSlot, (unsigned)mSlots, (unsigned)mSlot_ms, (unsigned)(mPeriod_ms / 1000));
+}
@@ -0,0 +1,43 @@
+#ifndef BEACON_SLOT_H_
+#define BEACON_SLOT_H_
+
+#include <Arduino.h>
+#include <TimeLib.h>
+
+// Transmit slots for a fleet on the same beacon period. The period is cut in
+// slots of the longest frame plus a second of guard, counted in the UTC time
+// from the GPS since 1970, and each unit sends at the start of the slot
+// picked by a hash of its callsign: units switched on together no longer stay
+// in step on the channel.
+class BeaconSlot {
+public:
+  BeaconSlot();
+
+  void begin(const String &callsign, uint32_t period_s, uint32_t time_on_air_us);
+  // The UTC second utc began at millis() at_ms.
+  void sync(time_t utc, unsigned long at_ms);
+  bool synced() const;
+  // 0 inside the slot while a frame still fits before its end, else the ms
+  // until the slot starts again.
+  uint32_t wait_ms(unsigned long now_ms) const;
+  // ms of sleep to be up lead_ms before a start of the slot, at least a
+  // second.
+  uint32_t sleep_ms(unsigned long now_ms, uint32_t lead_ms) const;
+  void     print(Print &out) const;
+
+private:
+  static const uint32_t Guard_ms = 1000;
+
+  uint32_t sinceStart_ms(unsigned long now_ms) const;
+
+  uint32_t      mPeriod_ms;
+  uint32_t      mSlot_ms;
+  uint32_t      mSlots;
+  uint32_t      mSlot;
+  uint32_t      mTimeOnAir_ms;
+  bool          mSynced;
+  uint64_t      mUtc_ms; // at millis() mAt_ms
+  unsigned long mAt_ms;
+};
+
+#endif
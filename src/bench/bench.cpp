@@ -0,0 +1,354 @@
+// Times the work done at each wake up, in ns per operation with the heap
+// allocations and peak heap use of each, on the host or on the T-Beam. Built
+// instead of LoRa_APRS_Beacon.cpp by the bench environments of
+// platformio.ini; tools/bench_compare.py checks two runs for regressions.
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <TinyGPS++.h>
+
+#ifdef NATIVE
+#include <chrono>
+#include <new>
+#endif
+
+#include "../airtime.h"
+#include "../beacon_frame.h"
+#include "../configuration.h"
+#include "../frame_builder.h"
+#include "../geofence.h"
+#include "../gps_task.h"
+#include "../position_batch.h"
+#include "nmea_corpus.h"
+
+static const uint64_t MinRun_ns = 100000000ULL;
+
+// malloc() and its friends are wrapped at link time (-Wl,--wrap), the blocks
+// allocated while a benchmark runs are kept in a table for the bytes in use.
+// Only those of the task running the benchmark are counted: the table has no
+// lock, and the other tasks of the T-Beam allocate at any time.
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void  __real_free(void *ptr);
+}
+
+struct Block {
+  void  *ptr;
+  size_t size;
+};
+
+static const int Blocks = 256;
+static Block     gBlocks[Blocks];
+static bool      gTracking;
+static uint32_t  gAllocations;
+static uint32_t  gUntracked; // blocks the table was too full for
+static size_t    gInUse;
+static size_t    gPeak;
+
+#ifdef NATIVE
+static bool tracked_task() {
+  return true;
+}
+#else
+static TaskHandle_t gTask;
+
+static bool tracked_task() {
+  return xTaskGetCurrentTaskHandle() == gTask;
+}
+#endif
+
+static int block_slot(void *ptr) {
+  return ((uintptr_t)ptr >> 3) % Blocks;
+}
+
+static void allocated(void *ptr, size_t size) {
+  if (!gTracking || !ptr || !tracked_task()) {
+    return;
+  }
+  gAllocations++;
+  for (int i = 0, slot = block_slot(ptr); i < Blocks; i++, slot = (slot + 1) % Blocks) {
+    if (!gBlocks[slot].ptr) {
+      gBlocks[slot].ptr  = ptr;
+      gBlocks[slot].size = size;
+      gInUse += size;
+      gPeak = max(gPeak, gInUse);
+      return;
+    }
+  }
+  gUntracked++;
+}
+
+static void released(void *ptr) {
+  if (!gTracking || !ptr || !tracked_task()) {
+    return;
+  }
+  // blocks from before the run are not in the table
+  for (int i = 0, slot = block_slot(ptr); i < Blocks && gBlocks[slot].ptr; i++, slot = (slot + 1) % Blocks) {
+    if (gBlocks[slot].ptr == ptr) {
+      gInUse -= gBlocks[slot].size;
+      // the probe sequence must not break: move the following entries back
+      gBlocks[slot].ptr = NULL;
+      for (int next = (slot + 1) % Blocks; gBlocks[next].ptr; next = (next + 1) % Blocks) {
+        Block block       = gBlocks[next];
+        gBlocks[next].ptr = NULL;
+        for (int at = block_slot(block.ptr);; at = (at + 1) % Blocks) {
+          if (!gBlocks[at].ptr) {
+            gBlocks[at] = block;
+            break;
+          }
+        }
+      }
+      return;
+    }
+  }
+}
+
+extern "C" {
+void *__wrap_malloc(size_t size) {
+  void *ptr = __real_malloc(size);
+  allocated(ptr, size);
+  return ptr;
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  void *ptr = __real_calloc(count, size);
+  allocated(ptr, count * size);
+  return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  void *moved = __real_realloc(ptr, size);
+  if (moved || !size) {
+    released(ptr);
+    allocated(moved, size);
+  }
+  return moved;
+}
+
+void __wrap_free(void *ptr) {
+  released(ptr);
+  __real_free(ptr);
+}
+}
+
+#ifdef NATIVE
+// libstdc++ is a shared library on the host, its operator new does not go
+// through the wrapped malloc()
+void *operator new(size_t size) {
+  void *ptr = malloc(size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  free(ptr);
+}
+#endif
+
+static uint64_t clock_ns() {
+#ifdef NATIVE
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+  // the cycle counter wraps every 18 s at 240 MHz, a run is much shorter
+  static uint32_t last;
+  static uint64_t cycles;
+  uint32_t        count = ESP.getCycleCount();
+  cycles += (uint32_t)(count - last);
+  last = count;
+  return cycles * 1000 / getCpuFrequencyMhz();
+#endif
+}
+
+// Runs fn once to warm up, then as many times as fill MinRun_ns, at most
+// max_iterations. The peak is too low when blocks were left out of the table,
+// their number ends the line.
+static void run(const char *name, void (*fn)(), uint32_t max_iterations = 1UL << 24) {
+#ifndef NATIVE
+  gTask = xTaskGetCurrentTaskHandle();
+#endif
+  fn();
+  uint32_t iterations = 1;
+  while (true) {
+    memset(gBlocks, 0, sizeof(gBlocks));
+    gAllocations = 0;
+    gUntracked   = 0;
+    gInUse       = 0;
+    gPeak        = 0;
+    gTracking    = true;
+    uint64_t start = clock_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+      fn();
+    }
+    uint64_t elapsed = clock_ns() - start;
+    gTracking        = false;
+    if (elapsed >= MinRun_ns || iterations >= max_iterations) {
+      Serial.printf("BENCH %-28s %12.1f ns/op %8.2f allocs/op %8u B peak", name, (double)elapsed / iterations, (double)gAllocations / iterations, (unsigned)gPeak);
+      if (gUntracked) {
+        Serial.printf(", %u blocks untracked", (unsigned)gUntracked);
+      }
+      Serial.println();
+      return;
+    }
+    // aim past MinRun_ns from what this run took
+    uint64_t wanted = elapsed ? MinRun_ns * 2 * iterations / elapsed : (uint64_t)iterations * 16;
+    iterations      = (uint32_t)min((uint64_t)max_iterations, max(wanted, (uint64_t)iterations * 2));
+  }
+}
+
+static Configuration  gConfig;
+static GpsFix         gFix;
+static PositionBatch  gBatch;
+static TinyGPSPlus    gGps;
+static char           gBuffer[255];
+static FrameBuilder   gFrame(gBuffer, sizeof(gBuffer));
+static Geofence       gGeofence("/geofence.bin");
+static uint32_t       gCounter;
+
+static RawDegrees raw(double degrees) {
+  RawDegrees raw;
+  raw.negative   = degrees < 0;
+  degrees        = fabs(degrees);
+  raw.deg        = (uint16_t)degrees;
+  raw.billionths = (uint32_t)lround((degrees - raw.deg) * 1e9);
+  return raw;
+}
+
+static void position_frame() {
+  build_position_frame(gFrame, gConfig.beacon, gFix, gBatch, true, "4.12V", 0);
+}
+
+static void setup_fix() {
+  gFix.location_valid = true;
+  gFix.location_fresh = true;
+  gFix.lat_deg        = 45.75972;
+  gFix.lng_deg        = 4.84139;
+  gFix.lat            = raw(gFix.lat_deg);
+  gFix.lng            = raw(gFix.lng_deg);
+  gFix.altitude_m     = 172.4;
+  gFix.speed_kmph     = 42.6;
+  gFix.speed_knots    = 23.0;
+  gFix.course_deg     = 87.5;
+  gFix.satellites     = 8;
+  gFix.hdop           = 102;
+  gBatch.begin(8);
+  for (int i = 8; i >= 0; i--) {
+    gBatch.add(1792000000UL - 60 * i, gFix.lat_deg - 0.0004 * i, gFix.lng_deg + 0.0007 * i);
+  }
+}
+
+static void bench_frames() {
+  run("frame.append_number_pad", [] {
+    gFrame.reset();
+    gFrame.appendNumber(gCounter++ % 60, 2);
+  });
+  run("frame.append_latitude", [] {
+    gFrame.reset();
+    gFrame.appendLatitude(gFix.lat, 1);
+  });
+  run("frame.append_longitude", [] {
+    gFrame.reset();
+    gFrame.appendLongitude(gFix.lng, 1);
+  });
+  gConfig.beacon.format = Configuration::Beacon::Uncompressed;
+  run("frame.position_uncompressed", position_frame);
+  gConfig.beacon.format = Configuration::Beacon::Compressed;
+  run("frame.position_compressed", position_frame);
+  gConfig.beacon.format = Configuration::Beacon::MicE;
+  run("frame.position_mic_e", position_frame);
+  gConfig.beacon.format = Configuration::Beacon::Compressed;
+  run("frame.position_batch_8", [] {
+    build_position_frame(gFrame, gConfig.beacon, gFix, gBatch, true, "4.12V", 8);
+  });
+  run("frame.status", [] {
+    build_status_frame(gFrame, gConfig.beacon, "4.12V");
+  });
+  run("frame.time_on_air", [] {
+    lora_time_on_air_us(gConfig.lora, 60 + gCounter++ % 64);
+  });
+}
+
+static void bench_gps() {
+  run("gps.encode_corpus", [] {
+    for (const char *c = NmeaCorpus; *c; c++) {
+      gGps.encode(*c);
+    }
+  });
+  Serial.printf("      (%d sentences, %u bytes per op)\n", NmeaCorpusSentences, (unsigned)(sizeof(NmeaCorpus) - 1));
+}
+
+// The JSON parse writes the NVS image each time, few runs spare the flash.
+static void bench_configuration() {
+  if (!SPIFFS.begin() || !SPIFFS.exists("/beacon.json")) {
+    Serial.println("      no /beacon.json, configuration skipped");
+    return;
+  }
+  run("config.read_cached", [] {
+    ConfigurationManagement manager("/beacon.json");
+    gConfig = manager.readConfiguration();
+  });
+  run("config.read_image", [] {
+    ConfigurationManagement::readImage(gConfig);
+  });
+  run(
+      "config.read_parse",
+      [] {
+        Preferences prefs;
+        prefs.begin("beacon", false);
+        prefs.remove("config");
+        prefs.end();
+        ConfigurationManagement manager("/beacon.json");
+        gConfig = manager.readConfiguration();
+      },
+      4);
+}
+
+// Points around the fix, in and out of the last cell.
+static void bench_geofence() {
+  if (!SPIFFS.exists("/geofence.bin")) {
+    Serial.println("      no /geofence.bin, geofence skipped");
+    return;
+  }
+  gGeofence.begin(gConfig);
+  run("geofence.lookup", [] {
+    uint32_t i = gCounter++;
+    gGeofence.lookup(lround(gFix.lat_deg * 1e5) + (int32_t)(i % 16) * 2500 - 20000, lround(gFix.lng_deg * 1e5) + (int32_t)(i / 16 % 16) * 2500 - 20000);
+  });
+}
+
+void setup() {
+  Serial.begin(115200);
+#ifdef NATIVE
+  Serial.println("bench on the host");
+#else
+  setCpuFrequencyMhz(240);
+  delay(1000);
+  Serial.printf("bench on the ESP32 at %u MHz, %u bytes of heap free\n", (unsigned)getCpuFrequencyMhz(), (unsigned)ESP.getFreeHeap());
+#endif
+  setup_fix();
+  bench_frames();
+  bench_gps();
+  bench_configuration();
+  bench_geofence();
+  Serial.println("bench done");
+}
+
+void loop() {
+#ifdef NATIVE
+  exit(0);
+#else
+  delay(1000);
+#endif
+}
@@ -0,0 +1,49 @@
+#ifndef NMEA_CORPUS_H_
+#define NMEA_CORPUS_H_
+
+// The first bursts of sim/sample.nmea, every sentence a receiver sends before
+// gps_configure() keeps only RMC and GGA.
+static const char NmeaCorpus[] =
+    "$GPRMC,083000.00,A,4545.58320,N,00450.48370,E,0.000,,161026,,,A*7C\r\n"
+    "$GPVTG,,T,,M,0.000,N,0.000,K,A*23\r\n"
+    "$GPGGA,083000.00,4545.58320,N,00450.48370,E,1,08,1.02,172.4,M,47.6,M,,*5C\r\n"
+    "$GPGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.83,1.02,1.52*0A\r\n"
+    "$GPGSV,3,1,11,02,45,120,38,05,33,060,36,12,71,300,42,13,12,200,29*7E\r\n"
+    "$GPGSV,3,2,11,15,28,250,33,18,55,040,40,25,20,160,31,29,40,090,35*78\r\n"
+    "$GPGSV,3,3,11,21,05,330,,24,09,020,,26,03,180,*4C\r\n"
+    "$GPGLL,4545.58320,N,00450.48370,E,083000.00,A,A*67\r\n"
+    "$GPRMC,083001.00,A,4545.58344,N,00450.48320,E,0.000,,161026,,,A*7A\r\n"
+    "$GPVTG,,T,,M,0.000,N,0.000,K,A*23\r\n"
+    "$GPGGA,083001.00,4545.58344,N,00450.48320,E,1,08,1.02,172.6,M,47.6,M,,*58\r\n"
+    "$GPGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.83,1.02,1.52*0A\r\n"
+    "$GPGSV,3,1,11,02,45,120,38,05,33,060,36,12,71,300,42,13,12,200,29*7E\r\n"
+    "$GPGSV,3,2,11,15,28,250,33,18,55,040,40,25,20,160,31,29,40,090,35*78\r\n"
+    "$GPGSV,3,3,11,21,05,330,,24,09,020,,26,03,180,*4C\r\n"
+    "$GPGLL,4545.58344,N,00450.48320,E,083001.00,A,A*61\r\n"
+    "$GPRMC,083002.00,A,4545.58314,N,00450.48337,E,0.000,,161026,,,A*7A\r\n"
+    "$GPVTG,,T,,M,0.000,N,0.000,K,A*23\r\n"
+    "$GPGGA,083002.00,4545.58314,N,00450.48337,E,1,08,1.02,172.8,M,47.6,M,,*56\r\n"
+    "$GPGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.83,1.02,1.52*0A\r\n"
+    "$GPGSV,3,1,11,02,45,120,38,05,33,060,36,12,71,300,42,13,12,200,29*7E\r\n"
+    "$GPGSV,3,2,11,15,28,250,33,18,55,040,40,25,20,160,31,29,40,090,35*78\r\n"
+    "$GPGSV,3,3,11,21,05,330,,24,09,020,,26,03,180,*4C\r\n"
+    "$GPGLL,4545.58314,N,00450.48337,E,083002.00,A,A*61\r\n"
+    "$GPRMC,083003.00,A,4545.58298,N,00450.48364,E,0.000,,161026,,,A*78\r\n"
+    "$GPVTG,,T,,M,0.000,N,0.000,K,A*23\r\n"
+    "$GPGGA,083003.00,4545.58298,N,00450.48364,E,1,08,1.02,173.1,M,47.6,M,,*5C\r\n"
+    "$GPGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.83,1.02,1.52*0A\r\n"
+    "$GPGSV,3,1,11,02,45,120,38,05,33,060,36,12,71,300,42,13,12,200,29*7E\r\n"
+    "$GPGSV,3,2,11,15,28,250,33,18,55,040,40,25,20,160,31,29,40,090,35*78\r\n"
+    "$GPGSV,3,3,11,21,05,330,,24,09,020,,26,03,180,*4C\r\n"
+    "$GPGLL,4545.58298,N,00450.48364,E,083003.00,A,A*63\r\n"
+    "$GPRMC,083004.00,A,4545.58332,N,00450.48311,E,0.000,,161026,,,A*7C\r\n"
+    "$GPVTG,,T,,M,0.000,N,0.000,K,A*23\r\n"
+    "$GPGGA,083004.00,4545.58332,N,00450.48311,E,1,08,1.02,173.3,M,47.6,M,,*5A\r\n"
+    "$GPGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.83,1.02,1.52*0A\r\n"
+    "$GPGSV,3,1,11,02,45,120,38,05,33,060,36,12,71,300,42,13,12,200,29*7E\r\n"
+    "$GPGSV,3,2,11,15,28,250,33,18,55,040,40,25,20,160,31,29,40,090,35*78\r\n"
+    "$GPGSV,3,3,11,21,05,330,,24,09,020,,26,03,180,*4C\r\n"
+    "$GPGLL,4545.58332,N,00450.48311,E,083004.00,A,A*67\r\n";
+static const int NmeaCorpusSentences = 40;
+
+#endif
@@ -0,0 +1,33 @@
+#include "boot_trace.h"
+
+BootTrace::BootTrace() : mCount(0), mBeaconSent(false), mFirstBeacon_ms(0) {
+}
+
+// cppcheck-suppress unusedFunction
+void BootTrace::mark(const char *step) {
+  if (mCount < Steps) {
+    mStep[mCount]    = step;
+    mTime_us[mCount] = micros();
+    mCount++;
+  }
+}
+
+// cppcheck-suppress unusedFunction
+bool BootTrace::firstBeacon() {
+  if (mBeaconSent) {
+    return false;
+  }
+  mBeaconSent     = true;
+  mFirstBeacon_ms = millis();
+  return true;
+}
+
+// cppcheck-suppress unusedFunction
+void BootTrace::print(Print &out) const {
+  out.println("boot        at ms      took ms");
+  uint32_t previous = 0;
+  for (int i = 0; i < mCount; i++) {
+    out.printf("%-10s %9.1f %12.1f\n", mStep[i], mTime_us[i] / 1000.0, (mTime_us[i] - previous) / 1000.0);
+    previous = mTime_us[i];
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef BOOT_TRACE_H_
+#define BOOT_TRACE_H_
+
+#include <Arduino.h>
+
+// Timeline of the bring-up in micros() since the application started (the ROM
+// and the second stage bootloader come before, about 30 ms more), and the
+// millis() at which the first beacon went on air.
+class BootTrace {
+public:
+  BootTrace();
+
+  void mark(const char *step);
+  // True on the first beacon sent since the boot.
+  bool firstBeacon();
+  void print(Print &out) const;
+
+  unsigned long firstBeacon_ms() const {
+    return mFirstBeacon_ms;
+  }
+
+private:
+  static const int Steps = 16;
+
+  const char   *mStep[Steps];
+  uint32_t      mTime_us[Steps];
+  int           mCount;
+  bool          mBeaconSent;
+  unsigned long mFirstBeacon_ms;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "config_image.h"
+
+static_assert(sizeof(ConfigImage) == 408, "ConfigImage layout changed, see tools/config_image.py");
+
+// cppcheck-suppress unusedFunction
+uint32_t config_crc32(uint32_t crc, const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  crc                  = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= bytes[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+static bool copy_text(char *field, size_t size, const String &text) {
+  if (text.length() >= size) {
+    return false;
+  }
+  memset(field, 0, size);
+  memcpy(field, text.c_str(), text.length());
+  return true;
+}
+
+// cppcheck-suppress unusedFunction
+bool config_image_pack(const Configuration &conf, uint32_t source_crc, ConfigImage &image) {
+  memset(&image, 0, sizeof(image));
+  image.magic      = ConfigImageMagic;
+  image.version    = ConfigImageVersion;
+  image.size       = sizeof(image);
+  image.source_crc = source_crc;
+
+  const Configuration::Beacon &beacon = conf.beacon;
+  if (!copy_text(image.callsign, sizeof(image.callsign), beacon.callsign) || !copy_text(image.path, sizeof(image.path), beacon.path) || !copy_text(image.message, sizeof(image.message), beacon.message) || !copy_text(image.symbol, sizeof(image.symbol), beacon.symbol) || !copy_text(image.overlay, sizeof(image.overlay), beacon.overlay)) {
+    return false;
+  }
+  image.timeout            = beacon.timeout;
+  image.positiondilution   = beacon.positiondilution;
+  image.max_backoff        = beacon.max_backoff;
+  image.slotted            = beacon.slotted;
+  image.batch_interval     = beacon.batch_interval;
+  image.batch_size         = beacon.batch_size;
+  image.filter             = beacon.filter;
+  image.min_distance       = beacon.min_distance;
+  image.max_skip           = beacon.max_skip;
+  image.max_hdop           = beacon.max_hdop;
+  image.slow_rate          = beacon.smart_beacon.slow_rate;
+  image.slow_speed         = beacon.smart_beacon.slow_speed;
+  image.fast_rate          = beacon.smart_beacon.fast_rate;
+  image.fast_speed         = beacon.smart_beacon.fast_speed;
+  image.turn_min           = beacon.smart_beacon.turn_min;
+  image.turn_slope         = beacon.smart_beacon.turn_slope;
+  image.turn_time          = beacon.smart_beacon.turn_time;
+  image.frequency_rx       = conf.lora.frequencyRx;
+  image.frequency_tx       = conf.lora.frequencyTx;
+  image.power              = conf.lora.power;
+  image.spreading_factor   = conf.lora.spreadingFactor;
+  image.signal_bandwidth   = conf.lora.signalBandwidth;
+  image.coding_rate4       = conf.lora.codingRate4;
+  image.preamble_length    = conf.lora.preambleLength;
+  image.max_defer          = conf.lora.maxDefer;
+  image.duty_cycle         = conf.lora.dutyCycle;
+  image.tx_current         = conf.lora.txCurrent;
+  image.gps_update_period  = conf.gps.update_period;
+  image.gps_baud           = conf.gps.baud;
+  image.cpu_low_mhz        = conf.cpu.low_mhz;
+  image.cpu_high_mhz       = conf.cpu.high_mhz;
+  image.ptt_io_pin         = conf.ptt.io_pin;
+  image.ptt_start_delay    = conf.ptt.start_delay;
+  image.ptt_end_delay      = conf.ptt.end_delay;
+  image.button_alt_message = conf.button.alt_message;
+
+  const Configuration::Governor &governor = conf.governor;
+  image.governor_active           = governor.active;
+  image.governor_capacity         = governor.capacity;
+  image.governor_hysteresis       = governor.hysteresis;
+  image.saving_below              = governor.saving.below;
+  image.saving_rate               = governor.saving.rate;
+  image.saving_power              = governor.saving.power;
+  image.saving_spreading_factor   = governor.saving.spreading_factor;
+  image.saving_display            = governor.saving.display;
+  image.survival_below            = governor.survival.below;
+  image.survival_rate             = governor.survival.rate;
+  image.survival_power            = governor.survival.power;
+  image.survival_spreading_factor = governor.survival.spreading_factor;
+  image.survival_display          = governor.survival.display;
+
+  image.telemetry_active       = conf.telemetry.active;
+  image.telemetry_format       = conf.telemetry.format;
+  image.telemetry_rate         = conf.telemetry.rate;
+  image.telemetry_oversampling = conf.telemetry.oversampling;
+  image.telemetry_filter       = conf.telemetry.filter;
+  image.track_active           = conf.track.active;
+  image.track_max_kb           = conf.track.max_kb;
+
+  image.format             = beacon.format;
+  image.timeout_action     = beacon.timeout_action;
+  image.gps_power_mode     = conf.gps.power_mode;
+
+  image.flags = (conf.debug ? ConfigFlagDebug : 0) | (conf.deep_sleep ? ConfigFlagDeepSleep : 0) | (beacon.smart_beacon.active ? ConfigFlagSmartBeacon : 0) | (conf.lora.crc ? ConfigFlagLoRaCrc : 0) | (conf.ptt.active ? ConfigFlagPtt : 0) | (conf.ptt.reverse ? ConfigFlagPttReverse : 0) | (conf.button.tx ? ConfigFlagButtonTx : 0) | (conf.lora.listenBeforeTalk ? ConfigFlagLoRaLbt : 0);
+  image.crc   = config_crc32(0, &image, offsetof(ConfigImage, crc));
+  return true;
+}
+
+// cppcheck-suppress unusedFunction
+bool config_image_valid(const ConfigImage &image) {
+  return image.magic == ConfigImageMagic && image.version == ConfigImageVersion && image.size == sizeof(image) && image.crc == config_crc32(0, &image, offsetof(ConfigImage, crc));
+}
+
+// cppcheck-suppress unusedFunction
+Configuration config_image_unpack(const ConfigImage &image) {
+  Configuration          conf;
+  Configuration::Beacon &beacon = conf.beacon;
+
+  conf.debug      = image.flags & ConfigFlagDebug;
+  conf.deep_sleep = image.flags & ConfigFlagDeepSleep;
+
+  beacon.callsign                = image.callsign;
+  beacon.path                    = image.path;
+  beacon.message                 = image.message;
+  beacon.symbol                  = image.symbol;
+  beacon.overlay                 = image.overlay;
+  beacon.timeout                 = image.timeout;
+  beacon.positiondilution        = image.positiondilution;
+  beacon.max_backoff             = image.max_backoff;
+  beacon.slotted                 = image.slotted;
+  beacon.batch_interval          = image.batch_interval;
+  beacon.batch_size              = image.batch_size;
+  beacon.filter                  = image.filter;
+  beacon.min_distance            = image.min_distance;
+  beacon.max_skip                = image.max_skip;
+  beacon.max_hdop                = image.max_hdop;
+  beacon.format                  = (Configuration::Beacon::Format)image.format;
+  beacon.timeout_action          = (Configuration::Beacon::TimeoutAction)image.timeout_action;
+  beacon.smart_beacon.active     = image.flags & ConfigFlagSmartBeacon;
+  beacon.smart_beacon.slow_rate  = image.slow_rate;
+  beacon.smart_beacon.slow_speed = image.slow_speed;
+  beacon.smart_beacon.fast_rate  = image.fast_rate;
+  beacon.smart_beacon.fast_speed = image.fast_speed;
+  beacon.smart_beacon.turn_min   = image.turn_min;
+  beacon.smart_beacon.turn_slope = image.turn_slope;
+  beacon.smart_beacon.turn_time  = image.turn_time;
+
+  conf.button.tx          = image.flags & ConfigFlagButtonTx;
+  conf.button.alt_message = image.button_alt_message;
+
+  Configuration::Governor &governor  = conf.governor;
+  governor.active                    = image.governor_active;
+  governor.capacity                  = image.governor_capacity;
+  governor.hysteresis                = image.governor_hysteresis;
+  governor.saving.below              = image.saving_below;
+  governor.saving.rate               = image.saving_rate;
+  governor.saving.power              = image.saving_power;
+  governor.saving.spreading_factor   = image.saving_spreading_factor;
+  governor.saving.display            = image.saving_display;
+  governor.survival.below            = image.survival_below;
+  governor.survival.rate             = image.survival_rate;
+  governor.survival.power            = image.survival_power;
+  governor.survival.spreading_factor = image.survival_spreading_factor;
+  governor.survival.display          = image.survival_display;
+
+  conf.telemetry.active       = image.telemetry_active;
+  conf.telemetry.format       = (Configuration::Telemetry::Format)image.telemetry_format;
+  conf.telemetry.rate         = image.telemetry_rate;
+  conf.telemetry.oversampling = image.telemetry_oversampling;
+  conf.telemetry.filter       = image.telemetry_filter;
+
+  conf.track.active = image.track_active;
+  conf.track.max_kb = image.track_max_kb;
+
+  conf.lora.frequencyRx      = image.frequency_rx;
+  conf.lora.frequencyTx      = image.frequency_tx;
+  conf.lora.power            = image.power;
+  conf.lora.spreadingFactor  = image.spreading_factor;
+  conf.lora.signalBandwidth  = image.signal_bandwidth;
+  conf.lora.codingRate4      = image.coding_rate4;
+  conf.lora.preambleLength   = image.preamble_length;
+  conf.lora.crc              = image.flags & ConfigFlagLoRaCrc;
+  conf.lora.dutyCycle        = image.duty_cycle;
+  conf.lora.txCurrent        = image.tx_current;
+  conf.lora.listenBeforeTalk = image.flags & ConfigFlagLoRaLbt;
+  conf.lora.maxDefer         = image.max_defer;
+
+  conf.gps.power_mode    = (Configuration::GPS::PowerMode)image.gps_power_mode;
+  conf.gps.update_period = image.gps_update_period;
+  conf.gps.baud          = image.gps_baud;
+
+  conf.cpu.low_mhz  = image.cpu_low_mhz;
+  conf.cpu.high_mhz = image.cpu_high_mhz;
+
+  conf.ptt.active      = image.flags & ConfigFlagPtt;
+  conf.ptt.io_pin      = image.ptt_io_pin;
+  conf.ptt.start_delay = image.ptt_start_delay;
+  conf.ptt.end_delay   = image.ptt_end_delay;
+  conf.ptt.reverse     = image.flags & ConfigFlagPttReverse;
+  return conf;
+}
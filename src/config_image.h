@@ -0,0 +1,109 @@
+#ifndef CONFIG_IMAGE_H_
+#define CONFIG_IMAGE_H_
+
+#include <Arduino.h>
+
+#include "configuration.h"
+
+// Fixed layout copy of the configuration, kept in NVS so that a boot does not
+// parse the JSON file again. Little endian without padding, 408 bytes;
+// tools/config_image.py writes the same image from a beacon.json. crc is the
+// CRC-32 (zlib) of all the bytes before it, source_crc that of the JSON text
+// the image was made from. Change ConfigImageVersion with the layout.
+struct ConfigImage {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  uint32_t source_crc;
+
+  char    callsign[16];
+  char    path[48];
+  char    message[96];
+  char    symbol[4];
+  char    overlay[4];
+  int32_t timeout;
+  int32_t positiondilution;
+  int32_t max_backoff;
+  int32_t slotted;
+  int32_t batch_interval;
+  int32_t batch_size;
+  int32_t filter;
+  int32_t min_distance;
+  int32_t max_skip;
+  int32_t slow_rate;
+  int32_t slow_speed;
+  int32_t fast_rate;
+  int32_t fast_speed;
+  int32_t turn_min;
+  int32_t turn_slope;
+  int32_t turn_time;
+  int32_t frequency_rx;
+  int32_t frequency_tx;
+  int32_t power;
+  int32_t spreading_factor;
+  int32_t signal_bandwidth;
+  int32_t coding_rate4;
+  int32_t preamble_length;
+  int32_t max_defer;
+  float   duty_cycle;
+  float   tx_current;
+  float   max_hdop;
+  int32_t gps_update_period;
+  int32_t gps_baud;
+  int32_t cpu_low_mhz;
+  int32_t cpu_high_mhz;
+  int32_t ptt_io_pin;
+  int32_t ptt_start_delay;
+  int32_t ptt_end_delay;
+  int32_t button_alt_message;
+  int32_t governor_active;
+  int32_t governor_capacity;
+  int32_t governor_hysteresis;
+  int32_t saving_below;
+  int32_t saving_rate;
+  int32_t saving_power;
+  int32_t saving_spreading_factor;
+  int32_t saving_display;
+  int32_t survival_below;
+  int32_t survival_rate;
+  int32_t survival_power;
+  int32_t survival_spreading_factor;
+  int32_t survival_display;
+  int32_t telemetry_active;
+  int32_t telemetry_format;
+  int32_t telemetry_rate;
+  int32_t telemetry_oversampling;
+  int32_t telemetry_filter;
+  int32_t track_active;
+  int32_t track_max_kb;
+  uint8_t format;
+  uint8_t timeout_action;
+  uint8_t gps_power_mode;
+  uint8_t flags; // ConfigFlag*
+
+  uint32_t crc;
+};
+
+static const uint32_t ConfigImageMagic   = 0x47464342; // "BCFG"
+static const uint16_t ConfigImageVersion = 9;
+
+enum ConfigFlag {
+  ConfigFlagDebug       = 0x01,
+  ConfigFlagDeepSleep   = 0x02,
+  ConfigFlagSmartBeacon = 0x04,
+  ConfigFlagLoRaCrc     = 0x08,
+  ConfigFlagPtt         = 0x10,
+  ConfigFlagPttReverse  = 0x20,
+  ConfigFlagButtonTx    = 0x40,
+  ConfigFlagLoRaLbt     = 0x80
+};
+
+// CRC-32 as zlib's crc32(), start with crc 0 and chain the calls.
+uint32_t config_crc32(uint32_t crc, const void *data, size_t length);
+
+// False when a text does not fit its field.
+bool          config_image_pack(const Configuration &conf, uint32_t source_crc, ConfigImage &image);
+bool          config_image_valid(const ConfigImage &image);
+Configuration config_image_unpack(const ConfigImage &image);
+
+#endif
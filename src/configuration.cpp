@@ -1,9 +1,11 @@
+#include <Preferences.h>
 #include <SPIFFS.h>
 
 #ifndef CPPCHECK
 #include <ArduinoJson.h>
 #endif
 
+#include "config_image.h"
 #include "configuration.h"
 
 ConfigurationManagement::ConfigurationManagement(String FilePath) : mFilePath(FilePath) {
@@ -13,22 +15,94 @@ ConfigurationManagement::ConfigurationManagement(String FilePath) : mFilePath(Fi
   }
 }
 
-// cppcheck-suppress unusedFunction
-Configuration ConfigurationManagement::readConfiguration() {
+static Configuration parse(DynamicJsonDocument &data);
+
+static bool load_image(ConfigImage &image) {
+  Preferences prefs;
+  if (!prefs.begin("beacon", true)) {
+    return false;
+  }
+  size_t length = prefs.getBytes("config", &image, sizeof(image));
+  prefs.end();
+  return length == sizeof(image) && config_image_valid(image);
+}
+
+static void store_image(const ConfigImage &image) {
+  Preferences prefs;
+  if (prefs.begin("beacon", false)) {
+    prefs.putBytes("config", &image, sizeof(image));
+    prefs.end();
+  }
+}
+
+bool ConfigurationManagement::fileCrc(uint32_t &crc) {
   File file = SPIFFS.open(mFilePath);
   if (!file) {
-    return Configuration();
+    return false;
   }
-  DynamicJsonDocument  data(2048);
-  DeserializationError error = deserializeJson(data, file);
+  uint8_t buffer[64];
+  size_t  length;
+  crc = 0;
+  while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+    crc = config_crc32(crc, buffer, length);
+  }
+  file.close();
+  return true;
+}
 
-  if (error) {
+// cppcheck-suppress unusedFunction
+Configuration ConfigurationManagement::readConfiguration() {
+  ConfigImage image;
+  bool        cached = load_image(image);
+  uint32_t    source_crc;
+  if (!fileCrc(source_crc)) {
+    return cached ? config_image_unpack(image) : Configuration();
+  }
+  if (cached && image.source_crc == source_crc) {
+    return config_image_unpack(image);
   }
+
+  File                 file = SPIFFS.open(mFilePath);
+  DynamicJsonDocument  data(4096);
+  DeserializationError error = deserializeJson(data, file);
   file.close();
+  if (error) {
+    Serial.printf("%s: %s\n", mFilePath.c_str(), error.c_str());
+    if (cached) {
+      Serial.println("Keeping the previous configuration");
+      return config_image_unpack(image);
+    }
+    return Configuration();
+  }
+  Configuration conf = parse(data);
+  if (config_image_pack(conf, source_crc, image)) {
+    store_image(image);
+  } else {
+    Serial.println("Configuration texts too long to be cached");
+  }
+  return conf;
+}
 
+// cppcheck-suppress unusedFunction
+bool ConfigurationManagement::readImage(Configuration &conf) {
+  ConfigImage image;
+  if (!load_image(image)) {
+    return false;
+  }
+  conf = config_image_unpack(image);
+  return true;
+}
+
+// cppcheck-suppress unusedFunction
+bool ConfigurationManagement::mount() {
+  return SPIFFS.begin();
+}
+
+static Configuration parse(DynamicJsonDocument &data) {
   Configuration conf;
 
-  conf.debug = data["debug"] | false;
+  conf.debug      = data["debug"] | false;
+  conf.deep_sleep = data["deep_sleep"] | false;
 
   // conf.beacon.callsign ="NOCALL-7";
   conf.beacon.callsign = data["beacon"]["callsign"].as<String>();
@@ -42,21 +116,92 @@ Configuration ConfigurationManagement::readConfiguration() {
   // conf.beacon.overlay ="/";
   conf.beacon.positiondilution        = data["beacon"]["positiondilution"] | 1;
   conf.beacon.overlay                 = data["beacon"]["overlay"].as<String>();
+  String format                       = data["beacon"]["format"] | "uncompressed";
+  if (format == "compressed") {
+    conf.beacon.format = Configuration::Beacon::Compressed;
+  } else if (format == "mic-e") {
+    conf.beacon.format = Configuration::Beacon::MicE;
+  } else {
+    conf.beacon.format = Configuration::Beacon::Uncompressed;
+  }
+  String timeout_action = data["beacon"]["timeout_action"] | "sleep";
+  if (timeout_action == "last_position") {
+    conf.beacon.timeout_action = Configuration::Beacon::TimeoutLastPosition;
+  } else if (timeout_action == "status") {
+    conf.beacon.timeout_action = Configuration::Beacon::TimeoutStatus;
+  } else {
+    conf.beacon.timeout_action = Configuration::Beacon::TimeoutSleep;
+  }
+  conf.beacon.max_backoff             = data["beacon"]["max_backoff"] | 8;
+  conf.beacon.slotted                 = data["beacon"]["slotted"] | false;
+  conf.beacon.batch_interval          = data["beacon"]["batch_interval"] | 0;
+  conf.beacon.batch_size              = data["beacon"]["batch_size"] | 8;
+  conf.beacon.filter                  = data["beacon"]["filter"] | false;
+  conf.beacon.max_hdop                = data["beacon"]["max_hdop"] | 5.0;
+  conf.beacon.min_distance            = data["beacon"]["min_distance"] | 0;
+  conf.beacon.max_skip                = data["beacon"]["max_skip"] | 5;
   conf.beacon.smart_beacon.active     = data["beacon"]["smart_beacon"]["active"] | false;
   conf.beacon.smart_beacon.slow_rate  = data["beacon"]["smart_beacon"]["slow_rate"] | 120;
   conf.beacon.smart_beacon.slow_speed = data["beacon"]["smart_beacon"]["slow_speed"] | 10;
   conf.beacon.smart_beacon.fast_rate  = data["beacon"]["smart_beacon"]["fast_rate"] | 10;
   conf.beacon.smart_beacon.fast_speed = data["beacon"]["smart_beacon"]["fast_speed"] | 100;
-  
+  conf.beacon.smart_beacon.turn_min   = data["beacon"]["smart_beacon"]["turn_min"] | 25;
+  conf.beacon.smart_beacon.turn_slope = data["beacon"]["smart_beacon"]["turn_slope"] | 410;
+  conf.beacon.smart_beacon.turn_time  = data["beacon"]["smart_beacon"]["turn_time"] | 15;
+
   conf.button.tx          = data["button"]["tx"] | false;
   conf.button.alt_message = data["button"]["alt_message"] | false;
 
-  conf.lora.frequencyRx     = data["lora"]["frequency_rx"] | 433775000;
-  conf.lora.frequencyTx     = data["lora"]["frequency_tx"] | 433775000;
-  conf.lora.power           = data["lora"]["power"] | 20;
-  conf.lora.spreadingFactor = data["lora"]["spreading_factor"] | 12;
-  conf.lora.signalBandwidth = data["lora"]["signal_bandwidth"] | 125000;
-  conf.lora.codingRate4     = data["lora"]["coding_rate4"] | 5;
+  conf.lora.frequencyRx      = data["lora"]["frequency_rx"] | 433775000;
+  conf.lora.frequencyTx      = data["lora"]["frequency_tx"] | 433775000;
+  conf.lora.power            = data["lora"]["power"] | 20;
+  conf.lora.spreadingFactor  = data["lora"]["spreading_factor"] | 12;
+  conf.lora.signalBandwidth  = data["lora"]["signal_bandwidth"] | 125000;
+  conf.lora.codingRate4      = data["lora"]["coding_rate4"] | 5;
+  conf.lora.preambleLength   = data["lora"]["preamble_length"] | 8;
+  conf.lora.crc              = data["lora"]["crc"] | true;
+  conf.lora.dutyCycle        = data["lora"]["duty_cycle"] | 0.0;
+  conf.lora.txCurrent        = data["lora"]["tx_current"] | 120.0;
+  conf.lora.listenBeforeTalk = data["lora"]["listen_before_talk"] | false;
+  conf.lora.maxDefer         = data["lora"]["max_defer"] | 30;
+
+  conf.gps.update_period = data["gps"]["update_period"] | 10;
+  conf.gps.baud          = data["gps"]["baud"] | 38400;
+  String power_mode      = data["gps"]["power_mode"] | "off";
+  if (power_mode == "backup") {
+    conf.gps.power_mode = Configuration::GPS::PowerBackup;
+  } else if (power_mode == "cyclic") {
+    conf.gps.power_mode = Configuration::GPS::PowerCyclic;
+  } else {
+    conf.gps.power_mode = Configuration::GPS::PowerOff;
+  }
+
+  conf.cpu.low_mhz  = data["cpu"]["low_mhz"] | 80;
+  conf.cpu.high_mhz = data["cpu"]["high_mhz"] | 240;
+
+  conf.governor.active                    = data["governor"]["active"] | false;
+  conf.governor.capacity                  = data["governor"]["capacity"] | 0;
+  conf.governor.hysteresis                = data["governor"]["hysteresis"] | 5;
+  conf.governor.saving.below              = data["governor"]["saving"]["below"] | 40;
+  conf.governor.saving.rate               = data["governor"]["saving"]["rate"] | 2;
+  conf.governor.saving.power              = data["governor"]["saving"]["power"] | 17;
+  conf.governor.saving.spreading_factor   = data["governor"]["saving"]["spreading_factor"] | 0;
+  conf.governor.saving.display            = data["governor"]["saving"]["display"] | false;
+  conf.governor.survival.below            = data["governor"]["survival"]["below"] | 15;
+  conf.governor.survival.rate             = data["governor"]["survival"]["rate"] | 4;
+  conf.governor.survival.power            = data["governor"]["survival"]["power"] | 10;
+  conf.governor.survival.spreading_factor = data["governor"]["survival"]["spreading_factor"] | 0;
+  conf.governor.survival.display          = data["governor"]["survival"]["display"] | false;
+
+  conf.telemetry.active       = data["telemetry"]["active"] | false;
+  String telemetry_format     = data["telemetry"]["format"] | "weather";
+  conf.telemetry.format       = telemetry_format == "telemetry" ? Configuration::Telemetry::FormatTelemetry : Configuration::Telemetry::FormatWeather;
+  conf.telemetry.rate         = data["telemetry"]["rate"] | 1800;
+  conf.telemetry.oversampling = data["telemetry"]["oversampling"] | 1;
+  conf.telemetry.filter       = data["telemetry"]["filter"] | 0;
+
+  conf.track.active = data["track"]["active"] | false;
+  conf.track.max_kb = data["track"]["max_kb"] | 512;
 
   conf.ptt.active      = data["ptt_output"]["active"] | false;
   conf.ptt.io_pin      = data["ptt_output"]["io_pin"] | 4;
@@ -12,39 +12,151 @@ public:
   public:
     class Smart_Beacon {
     public:
-      Smart_Beacon() : active(false), slow_rate(300), slow_speed(10), fast_rate(60), fast_speed(100) {
+      Smart_Beacon() : active(false), slow_rate(300), slow_speed(10), fast_rate(60), fast_speed(100), turn_min(25), turn_slope(410), turn_time(15) {
       }
       bool active;
-      int  slow_rate;
-      int  slow_speed;
-      int  fast_rate;
-      int  fast_speed;
+      int  slow_rate;  // s
+      int  slow_speed; // km/h
+      int  fast_rate;  // s
+      int  fast_speed; // km/h
+      int  turn_min;   // degrees
+      int  turn_slope; // degrees * km/h
+      int  turn_time;  // s
     };
 
-    Beacon() : callsign("NOCALL-7"), path("WIDE1-1"), message("LoRa Beacon"), timeout(1), symbol("["), overlay("/"), positiondilution(1) {
+    enum Format {
+      Uncompressed,
+      Compressed,
+      MicE
+    };
+
+    enum TimeoutAction {
+      TimeoutSleep,
+      TimeoutLastPosition,
+      TimeoutStatus
+    };
+
+    Beacon() : callsign("NOCALL-7"), path("WIDE1-1"), message("LoRa Beacon"), timeout(1), symbol("["), overlay("/"), positiondilution(1), format(Uncompressed), timeout_action(TimeoutSleep), max_backoff(8), slotted(false), batch_interval(0), batch_size(8), filter(false), max_hdop(5), min_distance(0), max_skip(5) {
     }
 
-    String       callsign;
-    String       path;
-    String       message;
-    int          timeout;
-    String       symbol;
-    String       overlay;
-    Smart_Beacon smart_beacon;
-    int          positiondilution;
+    String        callsign;
+    String        path;
+    String        message;
+    int           timeout; // minutes to get a fix, 0 waits forever
+    String        symbol;
+    String        overlay;
+    Smart_Beacon  smart_beacon;
+    int           positiondilution;
+    Format        format;
+    TimeoutAction timeout_action;
+    int           max_backoff;
+    bool          slotted;        // fixed period beacons in a slot of the GPS time
+    int           batch_interval; // s between fixes sent with the next beacon, 0 for none
+    int           batch_size;     // most fixes sent with a beacon
+    bool          filter;         // smooth the fixes before they are sent
+    float         max_hdop;       // fixes above are outliers, 0 for no limit
+    int           min_distance;   // m from the last beacon to send the next, 0 sends all
+    int           max_skip;       // beacons skipped in a row at most
   };
 
   class LoRa {
   public:
-    LoRa() : frequencyRx(433775000), frequencyTx(433775000), power(20), spreadingFactor(12), signalBandwidth(125000), codingRate4(5) {
+    LoRa() : frequencyRx(433775000), frequencyTx(433775000), power(20), spreadingFactor(12), signalBandwidth(125000), codingRate4(5), preambleLength(8), crc(true), dutyCycle(0), txCurrent(120), listenBeforeTalk(false), maxDefer(30) {
+    }
+
+    long  frequencyRx;
+    long  frequencyTx;
+    int   power;
+    int   spreadingFactor;
+    long  signalBandwidth;
+    int   codingRate4;
+    long  preambleLength;
+    bool  crc;
+    float dutyCycle; // % of each hour, 0 for no limit
+    float txCurrent; // mA while transmitting
+    bool  listenBeforeTalk;
+    int   maxDefer; // s a beacon waits at most for a clear channel
+  };
+
+  class GPS {
+  public:
+    enum PowerMode {
+      PowerOff,
+      PowerBackup,
+      PowerCyclic
+    };
+
+    GPS() : power_mode(PowerOff), update_period(10), baud(38400) {
+    }
+
+    PowerMode power_mode;
+    int       update_period; // s, for the cyclic mode
+    long      baud;
+  };
+
+  // CPU clock in MHz, 80, 160 or 240: low while waiting for the GPS, high
+  // while a frame is built and sent or the display is drawn.
+  class CPU {
+  public:
+    CPU() : low_mhz(80), high_mhz(240) {
+    }
+
+    int low_mhz;
+    int high_mhz;
+  };
+
+  // Operating profiles chosen by the charge left in the battery, see
+  // EnergyGovernor.
+  class Governor {
+  public:
+    class Profile {
+    public:
+      Profile(int below_, int rate_, int power_) : below(below_), rate(rate_), power(power_), spreading_factor(0), display(false) {
+      }
+
+      int  below;            // % of charge left under which it is used
+      int  rate;             // times the beacon period
+      int  power;            // dBm
+      int  spreading_factor; // 0 keeps lora.spreading_factor
+      bool display;          // the button still turns the panel on
+    };
+
+    Governor() : active(false), capacity(0), hysteresis(5), saving(40, 2, 17), survival(15, 4, 10) {
     }
 
-    long frequencyRx;
-    long frequencyTx;
-    int  power;
-    int  spreadingFactor;
-    long signalBandwidth;
-    int  codingRate4;
+    bool    active;
+    int     capacity;   // mAh, 0 for the voltage alone
+    int     hysteresis; // % above below to leave a profile
+    Profile saving;
+    Profile survival;
+  };
+
+  // BMP280 pressure and temperature sent at their own rate, see Sensor.
+  class Telemetry {
+  public:
+    enum Format {
+      FormatWeather,
+      FormatTelemetry
+    };
+
+    Telemetry() : active(false), format(FormatWeather), rate(1800), oversampling(1), filter(0) {
+    }
+
+    bool   active;
+    Format format;       // weather report or T# with the battery voltage
+    int    rate;         // s between frames
+    int    oversampling; // pressure, 1, 2, 4, 8 or 16
+    int    filter;       // IIR coefficient, 0, 2, 4, 8 or 16
+  };
+
+  // Every fix kept in a SPIFFS file, see TrackLog.
+  class Track {
+  public:
+    Track() : active(false), max_kb(512) {
+    }
+
+    bool active;
+    int  max_kb; // of SPIFFS for the file and the old one
   };
 
   class PTT {
@@ -68,22 +180,40 @@ public:
     int  alt_message;
   };
 
-  Configuration() : debug(false) {
+  Configuration() : debug(false), deep_sleep(false) {
   }
 
-  bool   debug;
-  Beacon beacon;
-  LoRa   lora;
-  PTT    ptt;
-  Button button;
+  bool      debug;
+  bool      deep_sleep;
+  Beacon    beacon;
+  LoRa      lora;
+  GPS       gps;
+  CPU       cpu;
+  Governor  governor;
+  Telemetry telemetry;
+  Track     track;
+  PTT       ptt;
+  Button    button;
 };
 
 class ConfigurationManagement {
 public:
   explicit ConfigurationManagement(String FilePath);
+  // From the image cached in NVS while it was made from the same file, the
+  // JSON is only parsed (and cached again) after the file changed.
   Configuration readConfiguration();
 
+  // The cached image alone, without SPIFFS. False when there is none.
+  static bool readImage(Configuration &conf);
+
+  // Mounts SPIFFS for the modules keeping files there, as a wake up from
+  // deep sleep reads the cached image and does not mount it for the
+  // configuration. Does nothing once mounted.
+  static bool mount();
+
 private:
+  bool fileCrc(uint32_t &crc);
+
   const String mFilePath;
 };
 
@@ -0,0 +1,110 @@
+#include "cpu_clock.h"
+
+static int valid_mhz(int mhz, int fallback) {
+  return (mhz == 80 || mhz == 160 || mhz == 240) ? mhz : fallback;
+}
+
+// cppcheck-suppress uninitMemberVar
+CpuClock::CpuClock() : mLow_mhz(240), mHigh_mhz(240), mHigh(true), mAwake(true), mSince_ms(0), mLow_ms(0), mHigh_ms(0) {
+#ifdef CONFIG_PM_ENABLE
+  mPm = false;
+#endif
+}
+
+// cppcheck-suppress unusedFunction
+void CpuClock::begin(int low_mhz, int high_mhz) {
+  mHigh_mhz = valid_mhz(high_mhz, 240);
+  mLow_mhz  = min(mHigh_mhz, valid_mhz(low_mhz, 80));
+  mHigh     = true;
+  mSince_ms = millis();
+#ifdef CONFIG_PM_ENABLE
+  esp_pm_config_esp32_t config;
+  config.max_freq_mhz       = mHigh_mhz;
+  config.min_freq_mhz       = mLow_mhz;
+  config.light_sleep_enable = false;
+  mPm                       = esp_pm_configure(&config) == ESP_OK && esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "beacon", &mLock) == ESP_OK;
+  if (mPm) {
+    esp_pm_lock_acquire(mLock);
+    return;
+  }
+#endif
+  apply();
+}
+
+void CpuClock::apply() {
+#ifdef CONFIG_PM_ENABLE
+  if (mPm) {
+    if (mHigh) {
+      esp_pm_lock_acquire(mLock);
+    } else {
+      esp_pm_lock_release(mLock);
+    }
+    return;
+  }
+#endif
+  setCpuFrequencyMhz(mHigh ? mHigh_mhz : mLow_mhz);
+}
+
+void CpuClock::account() {
+  unsigned long now = millis();
+  if (mAwake) {
+    (mHigh ? mHigh_ms : mLow_ms) += now - mSince_ms;
+  }
+  mSince_ms = now;
+}
+
+// cppcheck-suppress unusedFunction
+void CpuClock::high() {
+  if (!mHigh) {
+    account();
+    mHigh = true;
+    apply();
+  }
+}
+
+// cppcheck-suppress unusedFunction
+void CpuClock::low() {
+  if (mHigh) {
+    account();
+    mHigh = false;
+    apply();
+  }
+}
+
+// cppcheck-suppress unusedFunction
+void CpuClock::asleep() {
+  account();
+  mAwake = false;
+}
+
+// cppcheck-suppress unusedFunction
+void CpuClock::awake() {
+  account();
+  mAwake = true;
+}
+
+// cppcheck-suppress unusedFunction
+void CpuClock::reset() {
+  account();
+  mLow_ms  = 0;
+  mHigh_ms = 0;
+}
+
+// cppcheck-suppress unusedFunction
+void CpuClock::print(Print &out) {
+  account();
+  out.printf("CPU awake  %3d MHz %.1f s, %3d MHz %.1f s\n", mLow_mhz, mLow_ms / 1000.0, mHigh_mhz, mHigh_ms / 1000.0);
+}
+
+// cppcheck-suppress unusedFunction
+void CpuClock::retain(Retained &retained) {
+  account();
+  retained.low_ms  = mLow_ms;
+  retained.high_ms = mHigh_ms;
+}
+
+// cppcheck-suppress unusedFunction
+void CpuClock::resume(const Retained &retained) {
+  mLow_ms  = retained.low_ms;
+  mHigh_ms = retained.high_ms;
+}
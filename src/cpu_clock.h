@@ -0,0 +1,54 @@
+#ifndef CPU_CLOCK_H_
+#define CPU_CLOCK_H_
+
+#include <Arduino.h>
+
+#ifdef CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+// Two CPU clocks: low while the firmware only waits on the GPS UART, high for
+// the work that is over sooner at full speed. When the ESP-IDF power
+// management is built in, high() holds a CPU_FREQ_MAX lock and the PM falls
+// back to low by itself, otherwise setCpuFrequencyMhz() switches. Both stay
+// at or above 80 MHz so that the APB clock of the UART, I2C and SPI does not
+// change. The awake time at each clock is kept for the statistics.
+class CpuClock {
+public:
+  CpuClock();
+
+  void begin(int low_mhz, int high_mhz);
+  void high();
+  void low();
+  // Around a light sleep, which does not count as time at either clock.
+  void asleep();
+  void awake();
+
+  void reset();
+  void print(Print &out);
+
+  struct Retained {
+    uint64_t low_ms;
+    uint64_t high_ms;
+  };
+  void retain(Retained &retained);
+  void resume(const Retained &retained);
+
+private:
+  void account();
+  void apply();
+
+  int           mLow_mhz;
+  int           mHigh_mhz;
+  bool          mHigh;
+  bool          mAwake;
+  unsigned long mSince_ms;
+  uint64_t      mLow_ms;
+  uint64_t      mHigh_ms;
+#ifdef CONFIG_PM_ENABLE
+  esp_pm_lock_handle_t mLock;
+  bool                 mPm;
+#endif
+};
+
+#endif
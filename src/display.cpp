@@ -6,7 +6,57 @@
 #include "display.h"
 #include "pins.h"
 
-Adafruit_SSD1306 display(128, 64, &Wire, OLED_RST);
+#define DISPLAY_WIDTH   128
+#define DISPLAY_HEIGHT  64
+#define DISPLAY_PAGES   (DISPLAY_HEIGHT / 8)
+#define DISPLAY_ADDRESS 0x3c
+// data bytes per I2C transaction, after the control byte
+#define DISPLAY_CHUNK 31
+
+Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, OLED_RST);
+
+// what the panel shows, to send only the pages that differ
+static uint8_t       shown[DISPLAY_WIDTH * DISPLAY_PAGES];
+static bool          ready;
+static bool          panel_on;
+static unsigned long keep_start;
+static uint32_t      keep_ms;
+
+static bool page_changed(int page) {
+  return memcmp(display.getBuffer() + page * DISPLAY_WIDTH, shown + page * DISPLAY_WIDTH, DISPLAY_WIDTH) != 0;
+}
+
+// Each run of changed pages is one PAGEADDR/COLUMNADDR window.
+static void flush_pages() {
+  const uint8_t *buffer = display.getBuffer();
+  Wire.setClock(400000);
+  for (int first = 0; first < DISPLAY_PAGES; first++) {
+    if (!page_changed(first)) {
+      continue;
+    }
+    int last = first;
+    while (last + 1 < DISPLAY_PAGES && page_changed(last + 1)) {
+      last++;
+    }
+    display.ssd1306_command(SSD1306_PAGEADDR);
+    display.ssd1306_command(first);
+    display.ssd1306_command(last);
+    display.ssd1306_command(SSD1306_COLUMNADDR);
+    display.ssd1306_command(0);
+    display.ssd1306_command(DISPLAY_WIDTH - 1);
+    size_t start = first * DISPLAY_WIDTH;
+    size_t end   = (last + 1) * DISPLAY_WIDTH;
+    for (size_t i = start; i < end; i += DISPLAY_CHUNK) {
+      Wire.beginTransmission(DISPLAY_ADDRESS);
+      Wire.write((uint8_t)0x40);
+      Wire.write(buffer + i, min((size_t)DISPLAY_CHUNK, end - i));
+      Wire.endTransmission();
+    }
+    memcpy(shown + start, buffer + start, end - start);
+    first = last;
+  }
+  Wire.setClock(100000);
+}
 
 // cppcheck-suppress unusedFunction
 void setup_display() {
@@ -16,7 +66,7 @@ void setup_display() {
   digitalWrite(OLED_RST, HIGH);
 
   Wire.begin(OLED_SDA, OLED_SCL);
-  if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3c, false, false)) {
+  if (!display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_ADDRESS, false, false)) {
     while (true) {
     }
   }
@@ -29,124 +79,62 @@ void setup_display() {
   display.ssd1306_command(SSD1306_SETCONTRAST);
   display.ssd1306_command(1);
   display.display();
+  memcpy(shown, display.getBuffer(), sizeof(shown));
+  ready    = true;
+  panel_on = true;
 }
 
+// After a wake up from deep sleep the panel is set up again only when it is
+// switched on.
 void display_on(void) {
+  if (!ready) {
+    setup_display();
+  }
   display.ssd1306_command(SSD1306_DISPLAYON);
+  panel_on = true;
+  flush_pages();
 }
+
 void display_off(void) {
+  if (!ready) {
+    return;
+  }
   display.ssd1306_command(SSD1306_DISPLAYOFF);
+  panel_on = false;
+  keep_ms  = 0;
 }
 
 // cppcheck-suppress unusedFunction
-void show_display(String header, int wait) {
-  display.clearDisplay();
-  display.setTextColor(WHITE);
-  display.setTextSize(2);
-  display.setCursor(0, 0);
-  display.println(header);
-  display.ssd1306_command(SSD1306_SETCONTRAST);
-  display.ssd1306_command(1);
-  display.display();
-  delay(wait);
-}
-
-// cppcheck-suppress unusedFunction
-void show_display(String header, String line1, int wait) {
-  display.clearDisplay();
-  display.setTextColor(WHITE);
-  display.setTextSize(2);
-  display.setCursor(0, 0);
-  display.println(header);
-  display.setTextSize(1);
-  display.setCursor(0, 16);
-  display.println(line1);
-  display.ssd1306_command(SSD1306_SETCONTRAST);
-  display.ssd1306_command(1);
-  display.display();
-  delay(wait);
-}
-
-// cppcheck-suppress unusedFunction
-void show_display(String header, String line1, String line2, int wait) {
-  display.clearDisplay();
-  display.setTextColor(WHITE);
-  display.setTextSize(2);
-  display.setCursor(0, 0);
-  display.println(header);
-  display.setTextSize(1);
-  display.setCursor(0, 16);
-  display.println(line1);
-  display.setCursor(0, 26);
-  display.println(line2);
-  display.ssd1306_command(SSD1306_SETCONTRAST);
-  display.ssd1306_command(1);
-  display.display();
-  delay(wait);
-}
-
-// cppcheck-suppress unusedFunction
-void show_display(String header, String line1, String line2, String line3, int wait) {
+void show_display(const char *header, const char *line1, const char *line2, const char *line3, const char *line4, const char *line5) {
+  const char *lines[] = {line1, line2, line3, line4, line5};
+  if (!ready) {
+    return;
+  }
   display.clearDisplay();
   display.setTextColor(WHITE);
   display.setTextSize(2);
   display.setCursor(0, 0);
   display.println(header);
   display.setTextSize(1);
-  display.setCursor(0, 16);
-  display.println(line1);
-  display.setCursor(0, 26);
-  display.println(line2);
-  display.setCursor(0, 36);
-  display.println(line3);
-  display.ssd1306_command(SSD1306_SETCONTRAST);
-  display.ssd1306_command(1);
-  display.display();
-  delay(wait);
+  for (int i = 0; i < 5; i++) {
+    if (lines[i] && *lines[i]) {
+      display.setCursor(0, 16 + 10 * i);
+      display.println(lines[i]);
+    }
+  }
+  if (panel_on) {
+    flush_pages();
+  }
 }
 
 // cppcheck-suppress unusedFunction
-void show_display(String header, String line1, String line2, String line3, String line4, int wait) {
-  display.clearDisplay();
-  display.setTextColor(WHITE);
-  display.setTextSize(2);
-  display.setCursor(0, 0);
-  display.println(header);
-  display.setTextSize(1);
-  display.setCursor(0, 16);
-  display.println(line1);
-  display.setCursor(0, 26);
-  display.println(line2);
-  display.setCursor(0, 36);
-  display.println(line3);
-  display.setCursor(0, 46);
-  display.println(line4);
-  display.ssd1306_command(SSD1306_SETCONTRAST);
-  display.ssd1306_command(1);
-  display.display();
-  delay(wait);
+void display_keep(uint32_t ms) {
+  keep_start = millis();
+  keep_ms    = ms;
 }
 
 // cppcheck-suppress unusedFunction
-void show_display(String header, String line1, String line2, String line3, String line4, String line5, int wait) {
-  display.clearDisplay();
-  display.setTextColor(WHITE);
-  display.setTextSize(2);
-  display.setCursor(0, 0);
-  display.println(header);
-  display.setTextSize(1);
-  display.setCursor(0, 16);
-  display.println(line1);
-  display.setCursor(0, 26);
-  display.println(line2);
-  display.setCursor(0, 36);
-  display.println(line3);
-  display.setCursor(0, 46);
-  display.println(line4);
-  display.setCursor(0, 56);
-  display.println(line5);
-  display.ssd1306_command(SSD1306_SETCONTRAST);
-  display.ssd1306_command(1);
-  display.display();
-  delay(wait);
+uint32_t display_remaining_ms(unsigned long now_ms) {
+  unsigned long elapsed = now_ms - keep_start;
+  return elapsed < keep_ms ? keep_ms - elapsed : 0;
 }
@@ -1,15 +1,18 @@
-
 #ifndef DISPLAY_H_
 #define DISPLAY_H_
 
+#include <stdint.h>
+
 void setup_display();
 void display_on(void);
 void display_off(void);
-void show_display(String header, int wait = 0);
-void show_display(String header, String line1, int wait = 0);
-void show_display(String header, String line1, String line2, int wait = 0);
-void show_display(String header, String line1, String line2, String line3, int wait = 0);
-void show_display(String header, String line1, String line2, String line3, String line4, int wait = 0);
-void show_display(String header, String line1, String line2, String line3, String line4, String line5, int wait = 0);
+// Header in double size and up to five lines under it, empty or NULL lines
+// are left blank. Only the 8 pixel pages that changed go over I2C, and
+// nothing while the panel is off: display_on() sends what changed meanwhile.
+void show_display(const char *header, const char *line1 = NULL, const char *line2 = NULL, const char *line3 = NULL, const char *line4 = NULL, const char *line5 = NULL);
+// The panel should stay on ms from now, display_remaining_ms() tells how long
+// is left before display_off() is due.
+void     display_keep(uint32_t ms);
+uint32_t display_remaining_ms(unsigned long now_ms);
 
 #endif
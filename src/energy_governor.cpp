@@ -0,0 +1,153 @@
+#include "energy_governor.h"
+
+static const char *const ProfileNames[] = {"normal", "saving", "survival"};
+
+// State of charge of a LiPo cell at rest against its voltage.
+static const float Curve[][2] = {
+    {3.30f, 0},  {3.50f, 5},  {3.60f, 10}, {3.70f, 25}, {3.75f, 40},  {3.80f, 50},
+    {3.85f, 60}, {3.90f, 70}, {3.95f, 78}, {4.00f, 85}, {4.10f, 95}, {4.20f, 100},
+};
+static const int   CurvePoints    = sizeof(Curve) / sizeof(Curve[0]);
+static const float RestCurrent_mA = 50;           // ESP32 awake, GPS and radio off
+static const float VoltageTau_s   = 4 * 3600.0f; // of the pull towards the voltage
+
+EnergyGovernor::EnergyGovernor(PowerManagement &power) : mPower(power), mProfile(ProfileNormal), mPercent(100), mStartPercent(100), mStartCoulomb(0), mStarted(false), mRested_ms(0) {
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyGovernor::begin(const Configuration &conf) {
+  mBase   = conf;
+  mConfig = conf.governor;
+}
+
+float EnergyGovernor::voltage_percent(float volts) {
+  if (volts <= Curve[0][0]) {
+    return 0;
+  }
+  for (int i = 1; i < CurvePoints; i++) {
+    if (volts < Curve[i][0]) {
+      return Curve[i - 1][1] + (Curve[i][1] - Curve[i - 1][1]) * (volts - Curve[i - 1][0]) / (Curve[i][0] - Curve[i - 1][0]);
+    }
+  }
+  return 100;
+}
+
+// cppcheck-suppress unusedFunction
+bool EnergyGovernor::update() {
+  if (!mConfig.active) {
+    return false;
+  }
+  Profile profile = mProfile;
+  if (!mPower.isBatteryConnect() || mPower.isCharging()) {
+    profile = ProfileNormal;
+  } else {
+    // the voltage under load only starts the estimate, rested() follows it
+    float coulomb = mPower.getBatteryCoulomb();
+    if (!mStarted) {
+      mStarted      = true;
+      mStartPercent = voltage_percent(mPower.getBatteryVoltage());
+      mStartCoulomb = coulomb;
+    }
+    if (mConfig.capacity <= 0) {
+      mPercent = mStartPercent;
+    } else {
+      mPercent = max(0.0f, min(100.0f, counted(coulomb)));
+    }
+    // down as soon as under a threshold, up only hysteresis past it
+    const int below[] = {100, mConfig.saving.below, mConfig.survival.below};
+    Profile   wanted  = mPercent < below[ProfileSurvival] ? ProfileSurvival : (mPercent < below[ProfileSaving] ? ProfileSaving : ProfileNormal);
+    while (wanted < profile && mPercent < below[wanted + 1] + mConfig.hysteresis) {
+      wanted = (Profile)(wanted + 1);
+    }
+    profile = wanted;
+  }
+  if (profile == mProfile) {
+    return false;
+  }
+  mProfile = profile;
+  return true;
+}
+
+float EnergyGovernor::counted(float coulomb) const {
+  return mStartPercent + (coulomb - mStartCoulomb) * 100 / mConfig.capacity;
+}
+
+// At a wake up before the GPS and the radio draw: the cell rested over the
+// sleep and its voltage tells the charge. The count moves towards it by the
+// time since the previous reading over VoltageTau_s, so that the voltage only
+// corrects its drift over hours.
+// cppcheck-suppress unusedFunction
+void EnergyGovernor::rested(unsigned long now_ms) {
+  if (!mConfig.active || !mStarted || !mPower.isBatteryConnect() || mPower.isCharging() || -mPower.getBatteryChargeDischargeCurrent() > RestCurrent_mA) {
+    return;
+  }
+  float elapsed_s = (now_ms - mRested_ms) / 1000.0f;
+  mRested_ms      = now_ms;
+  float voltage   = voltage_percent(mPower.getBatteryVoltage());
+  if (mConfig.capacity <= 0) {
+    mStartPercent = voltage;
+    return;
+  }
+  mStartPercent += (1 - expf(-elapsed_s / VoltageTau_s)) * (voltage - counted(mPower.getBatteryCoulomb()));
+}
+
+const Configuration::Governor::Profile *EnergyGovernor::current() const {
+  switch (mProfile) {
+    case ProfileSaving:
+      return &mConfig.saving;
+    case ProfileSurvival:
+      return &mConfig.survival;
+    default:
+      return NULL;
+  }
+}
+
+// cppcheck-suppress unusedFunction
+bool EnergyGovernor::display() const {
+  const Configuration::Governor::Profile *profile = current();
+  return profile ? profile->display : true;
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyGovernor::apply(Configuration &conf) const {
+  const Configuration::Governor::Profile *profile = current();
+  int                                     rate    = profile ? max(1, profile->rate) : 1;
+  conf.beacon.smart_beacon.slow_rate *= rate;
+  conf.beacon.smart_beacon.fast_rate *= rate;
+  conf.lora.power                    = mBase.lora.power;
+  conf.lora.spreadingFactor          = mBase.lora.spreadingFactor;
+  if (profile) {
+    conf.lora.power = min(mBase.lora.power, profile->power);
+    if (profile->spreading_factor) {
+      conf.lora.spreadingFactor = profile->spreading_factor;
+    }
+  }
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyGovernor::print(Print &out) {
+  if (!mConfig.active) {
+    return;
+  }
+  out.printf("Battery    %.0f%% left, %s profile\n", mPercent, ProfileNames[mProfile]);
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyGovernor::retain(Retained &retained, unsigned long now_ms) const {
+  retained.profile       = mProfile;
+  retained.percent       = mPercent;
+  retained.start_percent = mStartPercent;
+  retained.start_coulomb = mStartCoulomb;
+  retained.started       = mStarted;
+  retained.rested_age_ms = now_ms - mRested_ms;
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyGovernor::resume(const Retained &retained, uint32_t slept_ms) {
+  mProfile      = retained.profile;
+  mPercent      = retained.percent;
+  mStartPercent = retained.start_percent;
+  mStartCoulomb = retained.start_coulomb;
+  mStarted      = retained.started;
+  mRested_ms    = 0UL - (retained.rested_age_ms + slept_ms);
+}
@@ -0,0 +1,70 @@
+#ifndef ENERGY_GOVERNOR_H_
+#define ENERGY_GOVERNOR_H_
+
+#include <Arduino.h>
+
+#include "configuration.h"
+#include "power_management.h"
+
+// Picks the operating profile from the charge left in the battery: normal,
+// then saving and survival under their thresholds, back up only once the
+// charge is hysteresis above them. The charge is counted by the AXP192 from
+// the state of charge its voltage gave at boot, and pulled slowly towards the
+// voltage curve at rest so that the count does not drift. Without a capacity
+// the voltage curve alone is used. On USB power the profile is normal.
+class EnergyGovernor {
+public:
+  enum Profile {
+    ProfileNormal,
+    ProfileSaving,
+    ProfileSurvival
+  };
+
+  explicit EnergyGovernor(PowerManagement &power);
+
+  void begin(const Configuration &conf);
+  // Reads the battery, true when the profile changed.
+  bool update();
+  // Reads the voltage at rest, once the tracker woke up and before the loads
+  // come on.
+  void rested(unsigned long now_ms);
+
+  Profile profile() const {
+    return mProfile;
+  }
+  bool display() const;
+  // The transmit power and spreading factor of the profile over those of the
+  // configuration given to begin(), the beacon periods of conf multiplied:
+  // they are set again before each call, see Geofence::apply().
+  void apply(Configuration &conf) const;
+  void print(Print &out);
+
+  static float voltage_percent(float volts);
+
+  struct Retained {
+    Profile  profile;
+    float    percent;
+    float    start_percent;
+    float    start_coulomb;
+    bool     started;
+    uint32_t rested_age_ms;
+  };
+  void retain(Retained &retained, unsigned long now_ms) const;
+  void resume(const Retained &retained, uint32_t slept_ms);
+
+private:
+  const Configuration::Governor::Profile *current() const;
+  float                                   counted(float coulomb) const;
+
+  PowerManagement        &mPower;
+  Configuration           mBase;
+  Configuration::Governor mConfig;
+  Profile                 mProfile;
+  float                   mPercent;
+  float                   mStartPercent; // at boot, from the voltage
+  float                   mStartCoulomb; // mAh counted at that time
+  bool                    mStarted;
+  unsigned long           mRested_ms; // of the last reading at rest
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "energy_stats.h"
+
+static const char *const PhaseNames[] = {"acquire", "build", "ptt", "transmit", "sleep"};
+
+void RollingSamples::add(float value) {
+  mValues[mNext] = value;
+  mNext          = (mNext + 1) % Size;
+  if (mCount < Size) {
+    mCount++;
+  }
+}
+
+void RollingSamples::clear() {
+  mCount = 0;
+  mNext  = 0;
+}
+
+int RollingSamples::count() const {
+  return mCount;
+}
+
+float RollingSamples::percentile(int p) const {
+  if (mCount == 0) {
+    return 0.0f;
+  }
+  float sorted[Size];
+  for (int i = 0; i < mCount; i++) {
+    float value = mValues[i];
+    int   j     = i;
+    for (; j > 0 && sorted[j - 1] > value; j--) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = value;
+  }
+  return sorted[(mCount - 1) * p / 100];
+}
+
+EnergyStats::EnergyStats(PowerManagement &power) : mPower(power), mPhase(PhaseAcquire), mPhaseStart(0), mPhaseCharge(0.0), mBeaconCharge(0.0) {
+  memset(mTotals, 0, sizeof(mTotals));
+  mAcquisition_ms.clear();
+  mBeacon_mAh.clear();
+}
+
+// the counter goes down while discharging
+double EnergyStats::used_mAh() {
+  return -mPower.getBatteryCoulomb();
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyStats::begin(Phase phase) {
+  mPhase        = phase;
+  mPhaseStart   = millis();
+  mPhaseCharge  = used_mAh();
+  mBeaconCharge = mPhaseCharge;
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyStats::enter(Phase phase) {
+  unsigned long now    = millis();
+  double        charge = used_mAh();
+  Total        &total  = mTotals[mPhase];
+  total.count++;
+  total.ms += now - mPhaseStart;
+  total.mAh += charge - mPhaseCharge;
+  total.mA += -mPower.getBatteryChargeDischargeCurrent();
+  mPhase       = phase;
+  mPhaseStart  = now;
+  mPhaseCharge = charge;
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyStats::acquired(unsigned long acquisition_ms) {
+  mAcquisition_ms.add(acquisition_ms);
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyStats::beacon() {
+  double charge = used_mAh();
+  mBeacon_mAh.add(charge - mBeaconCharge);
+  mBeaconCharge = charge;
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyStats::reset() {
+  memset(mTotals, 0, sizeof(mTotals));
+  mAcquisition_ms.clear();
+  mBeacon_mAh.clear();
+  begin(mPhase);
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyStats::print(Print &out) {
+  out.println("phase        count     time s        mAh  mA at end");
+  for (int i = 0; i < PhaseCount; i++) {
+    const Total &total = mTotals[i];
+    out.printf("%-10s %7u %10.1f %10.3f %10.1f\n", PhaseNames[i], (unsigned)total.count, total.ms / 1000.0, total.mAh, total.count ? total.mA / total.count : 0.0);
+  }
+  out.printf("GPS fix ms      min %.0f median %.0f p95 %.0f (last %d)\n", mAcquisition_ms.percentile(0), mAcquisition_ms.percentile(50), mAcquisition_ms.percentile(95), mAcquisition_ms.count());
+  out.printf("mAh per beacon  min %.3f median %.3f p95 %.3f (last %d)\n", mBeacon_mAh.percentile(0), mBeacon_mAh.percentile(50), mBeacon_mAh.percentile(95), mBeacon_mAh.count());
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyStats::retain(Retained &retained, unsigned long now_ms) const {
+  retained.phase          = mPhase;
+  retained.phase_age_ms   = now_ms - mPhaseStart;
+  retained.phase_charge   = mPhaseCharge;
+  retained.beacon_charge  = mBeaconCharge;
+  retained.acquisition_ms = mAcquisition_ms;
+  retained.beacon_mAh     = mBeacon_mAh;
+  memcpy(retained.totals, mTotals, sizeof(mTotals));
+}
+
+// cppcheck-suppress unusedFunction
+void EnergyStats::resume(const Retained &retained, uint32_t slept_ms) {
+  mPhase          = retained.phase;
+  mPhaseStart     = 0UL - (retained.phase_age_ms + slept_ms);
+  mPhaseCharge    = retained.phase_charge;
+  mBeaconCharge   = retained.beacon_charge;
+  mAcquisition_ms = retained.acquisition_ms;
+  mBeacon_mAh     = retained.beacon_mAh;
+  memcpy(mTotals, retained.totals, sizeof(mTotals));
+}
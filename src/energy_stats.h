@@ -0,0 +1,89 @@
+#ifndef ENERGY_STATS_H_
+#define ENERGY_STATS_H_
+
+#include <Arduino.h>
+
+#include "power_management.h"
+
+// Last samples of a measure, for min/median/p95 without keeping them all.
+// No constructor so that it can sit in RTC memory, clear() it before use.
+class RollingSamples {
+public:
+  void  add(float value);
+  void  clear();
+  int   count() const;
+  // p in percent, 0 is the minimum and 50 the median
+  float percentile(int p) const;
+
+  static const int Size = 32;
+
+private:
+  float mValues[Size];
+  int   mCount;
+  int   mNext;
+};
+
+// Time and charge of each phase of the beacon cycle. Charge comes from the
+// AXP192 coulomb counter: with its ~0.4 mAh step a single short phase can
+// read 0, the totals over many cycles are right.
+class EnergyStats {
+public:
+  enum Phase {
+    PhaseAcquire,
+    PhaseBuild,
+    PhasePtt,
+    PhaseTransmit,
+    PhaseSleep,
+    PhaseCount
+  };
+
+  explicit EnergyStats(PowerManagement &power);
+
+  void begin(Phase phase);
+  // Closes the running phase and starts the next one.
+  void enter(Phase phase);
+  void acquired(unsigned long acquisition_ms);
+  // Charge since the previous beacon, one sample per beacon sent.
+  void beacon();
+  void reset();
+  void print(Print &out);
+
+  // Percentile p of the last GPS acquisition times, 0 before the first fix.
+  float acquisition_ms(int p) const {
+    return mAcquisition_ms.percentile(p);
+  }
+
+  struct Total {
+    uint32_t count;
+    uint64_t ms;
+    double   mAh;
+    double   mA; // sum of the current read when the phase ends
+  };
+
+  // Everything kept over a deep sleep, see SmartBeacon::Retained.
+  struct Retained {
+    Phase          phase;
+    uint32_t       phase_age_ms;
+    double         phase_charge;
+    double         beacon_charge;
+    Total          totals[PhaseCount];
+    RollingSamples acquisition_ms;
+    RollingSamples beacon_mAh;
+  };
+  void retain(Retained &retained, unsigned long now_ms) const;
+  void resume(const Retained &retained, uint32_t slept_ms);
+
+private:
+  double used_mAh();
+
+  PowerManagement &mPower;
+  Phase            mPhase;
+  unsigned long    mPhaseStart;
+  double           mPhaseCharge;
+  double           mBeaconCharge;
+  Total            mTotals[PhaseCount];
+  RollingSamples   mAcquisition_ms;
+  RollingSamples   mBeacon_mAh;
+};
+
+#endif
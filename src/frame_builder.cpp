@@ -0,0 +1,198 @@
+#include "frame_builder.h"
+
+// minutes * 100 with the digits past precision cleared, as sent in the frame
+static uint32_t hundredthsOfMinute(uint32_t billionths, int precision) {
+  uint32_t minutes    = ((uint64_t)billionths * 6 + 5000) / 10000;
+  uint32_t hundredths = minutes % 10000 / 100;
+  if (precision <= 0) {
+    hundredths = 0;
+  } else if (precision == 1) {
+    hundredths -= hundredths % 10;
+  }
+  return minutes / 10000 * 100 + hundredths;
+}
+
+static int64_t nanodegrees(const RawDegrees &raw) {
+  int64_t value = (int64_t)raw.deg * 1000000000 + raw.billionths;
+  return raw.negative ? -value : value;
+}
+
+FrameBuilder::FrameBuilder(char *buffer, size_t size) : mBuffer(buffer), mSize(size), mLength(0), mOverflow(size == 0) {
+  if (mSize) {
+    mBuffer[0] = 0;
+  }
+}
+
+void FrameBuilder::reset() {
+  mLength   = 0;
+  mOverflow = mSize == 0;
+  if (mSize) {
+    mBuffer[0] = 0;
+  }
+}
+
+FrameBuilder &FrameBuilder::appendBytes(const char *data, size_t length) {
+  if (mOverflow || length >= mSize - mLength) {
+    mOverflow = true;
+    return *this;
+  }
+  memcpy(mBuffer + mLength, data, length);
+  mLength += length;
+  mBuffer[mLength] = 0;
+  return *this;
+}
+
+FrameBuilder &FrameBuilder::append(char c) {
+  return appendBytes(&c, 1);
+}
+
+FrameBuilder &FrameBuilder::append(const char *str) {
+  return appendBytes(str, strlen(str));
+}
+
+FrameBuilder &FrameBuilder::append(const String &str) {
+  return appendBytes(str.c_str(), str.length());
+}
+
+// cppcheck-suppress unusedFunction
+FrameBuilder &FrameBuilder::appendNumber(unsigned long number, unsigned int width) {
+  char  digits[20];
+  char *p = digits + sizeof(digits);
+  do {
+    *--p = '0' + number % 10;
+    number /= 10;
+  } while (number && p > digits);
+  while (digits + sizeof(digits) - p < (long)width && p > digits) {
+    *--p = '0';
+  }
+  return appendBytes(p, digits + sizeof(digits) - p);
+}
+
+// value / 10^decimals, e.g. appendFixed(-412, 2) gives "-4.12"
+// cppcheck-suppress unusedFunction
+FrameBuilder &FrameBuilder::appendFixed(long value, unsigned int decimals) {
+  unsigned long scale = 1;
+  for (unsigned int i = 0; i < decimals; i++) {
+    scale *= 10;
+  }
+  unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+  if (value < 0) {
+    append('-');
+  }
+  appendNumber(magnitude / scale);
+  if (decimals) {
+    append('.');
+    appendNumber(magnitude % scale, decimals);
+  }
+  return *this;
+}
+
+// APRS minutes "MM.mm", the minutes rounded to 4 decimals then truncated to
+// 2, digits past precision are sent as '0'.
+FrameBuilder &FrameBuilder::appendMinutes(uint32_t billionths, int precision) {
+  uint32_t minutes = hundredthsOfMinute(billionths, precision);
+  appendNumber(minutes / 100, 2);
+  append('.');
+  return appendNumber(minutes % 100, 2);
+}
+
+// cppcheck-suppress unusedFunction
+FrameBuilder &FrameBuilder::appendLatitude(const RawDegrees &lat, int precision) {
+  appendNumber(lat.deg, 2);
+  appendMinutes(lat.billionths, precision);
+  return append(lat.negative ? 'S' : 'N');
+}
+
+// cppcheck-suppress unusedFunction
+FrameBuilder &FrameBuilder::appendLongitude(const RawDegrees &lng, int precision) {
+  appendNumber(lng.deg, 3);
+  appendMinutes(lng.billionths, precision);
+  return append(lng.negative ? 'W' : 'E');
+}
+
+// cppcheck-suppress unusedFunction
+FrameBuilder &FrameBuilder::appendBase91(uint32_t value, unsigned int width) {
+  char digits[5];
+  if (width > sizeof(digits)) {
+    width = sizeof(digits);
+  }
+  for (int i = width - 1; i >= 0; i--) {
+    digits[i] = '!' + value % 91;
+    value /= 91;
+  }
+  return appendBytes(digits, width);
+}
+
+// APRS 1.0.1 chapter 9: "/YYYYXXXX$csT" with course/speed in cs and T telling
+// a current GPS fix from RMC, software encoded.
+// cppcheck-suppress unusedFunction
+FrameBuilder &FrameBuilder::appendCompressedPosition(const RawDegrees &lat, const RawDegrees &lng, char table, char symbol, int course, double knots) {
+  if (table >= '0' && table <= '9') {
+    table = 'a' + table - '0';
+  }
+  append(table);
+  appendBase91((uint32_t)(380926LL * (90000000000LL - nanodegrees(lat)) / 1000000000LL), 4);
+  appendBase91((uint32_t)(190463LL * (180000000000LL + nanodegrees(lng)) / 1000000000LL), 4);
+  append(symbol);
+  append((char)('!' + (course % 360 + 360) % 360 / 4));
+  append((char)('!' + min(89L, lround(log(max(knots, 0.0) + 1.0) / log(1.08)))));
+  return append((char)('!' + 0x3A));
+}
+
+// Mic-E destination address carrying the latitude, the "En Route" message
+// bits and the N/S, longitude offset and W/E flags (APRS 1.0.1 chapter 10).
+// cppcheck-suppress unusedFunction
+FrameBuilder &FrameBuilder::appendMicEDestination(const RawDegrees &lat, const RawDegrees &lng, int precision) {
+  uint32_t minutes = hundredthsOfMinute(lat.billionths, precision);
+  char     digits[6];
+  digits[0] = lat.deg / 10 % 10;
+  digits[1] = lat.deg % 10;
+  digits[2] = minutes / 1000 % 10;
+  digits[3] = minutes / 100 % 10;
+  digits[4] = minutes / 10 % 10;
+  digits[5] = minutes % 10;
+  bool flags[6] = {true, true, false, !lat.negative, lng.deg < 10 || lng.deg >= 100, lng.negative};
+  for (int i = 0; i < 6; i++) {
+    append((char)((flags[i] ? 'P' : '0') + digits[i]));
+  }
+  return *this;
+}
+
+FrameBuilder &FrameBuilder::appendMicEChar(int value) {
+  return append((char)(value + 28));
+}
+
+// Mic-E information field: longitude, speed and course, symbol and the
+// altitude in the status text.
+// cppcheck-suppress unusedFunction
+FrameBuilder &FrameBuilder::appendMicEPosition(const RawDegrees &lng, int precision, char table, char symbol, int course, int knots, long altitude_m) {
+  uint32_t minutes = hundredthsOfMinute(lng.billionths, precision);
+  int      degrees = lng.deg;
+  if (degrees < 10) {
+    degrees += 90;
+  } else if (degrees >= 110) {
+    degrees -= 100;
+  } else if (degrees >= 100) {
+    degrees -= 20;
+  }
+  int minute = minutes / 100;
+  if (minute < 10) {
+    minute += 60;
+  }
+  knots     = max(0, min(799, knots));
+  course    = max(0, min(360, course));
+  int speed = knots / 10;
+  int dc    = knots % 10 * 10 + course / 100;
+  if (speed < 4) {
+    speed += 80;
+  }
+  if (dc < 4) {
+    dc += 4;
+  }
+  append('`');
+  appendMicEChar(degrees).appendMicEChar(minute).appendMicEChar(minutes % 100);
+  appendMicEChar(speed).appendMicEChar(dc).appendMicEChar(course % 100);
+  append(symbol).append(table);
+  appendBase91((uint32_t)max(0L, altitude_m + 10000), 3);
+  return append('}');
+}
@@ -0,0 +1,48 @@
+#ifndef FRAME_BUILDER_H_
+#define FRAME_BUILDER_H_
+
+#include <Arduino.h>
+#include <TinyGPS++.h>
+
+// Appends text to a caller-owned buffer, always NUL terminated. Once an append
+// does not fit the builder stops writing and overflow() is set.
+class FrameBuilder {
+public:
+  FrameBuilder(char *buffer, size_t size);
+
+  void reset();
+
+  FrameBuilder &append(char c);
+  FrameBuilder &append(const char *str);
+  FrameBuilder &append(const String &str);
+  FrameBuilder &appendNumber(unsigned long number, unsigned int width = 1);
+  FrameBuilder &appendFixed(long value, unsigned int decimals);
+  FrameBuilder &appendLatitude(const RawDegrees &lat, int precision);
+  FrameBuilder &appendLongitude(const RawDegrees &lng, int precision);
+  FrameBuilder &appendBase91(uint32_t value, unsigned int width);
+  FrameBuilder &appendCompressedPosition(const RawDegrees &lat, const RawDegrees &lng, char table, char symbol, int course, double knots);
+  FrameBuilder &appendMicEDestination(const RawDegrees &lat, const RawDegrees &lng, int precision);
+  FrameBuilder &appendMicEPosition(const RawDegrees &lng, int precision, char table, char symbol, int course, int knots, long altitude_m);
+
+  const char *c_str() const {
+    return mBuffer;
+  }
+  size_t length() const {
+    return mLength;
+  }
+  bool overflow() const {
+    return mOverflow;
+  }
+
+private:
+  FrameBuilder &appendBytes(const char *data, size_t length);
+  FrameBuilder &appendMinutes(uint32_t billionths, int precision);
+  FrameBuilder &appendMicEChar(int value);
+
+  char  *mBuffer;
+  size_t mSize;
+  size_t mLength;
+  bool   mOverflow;
+};
+
+#endif
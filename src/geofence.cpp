@@ -0,0 +1,179 @@
+#include <SPIFFS.h>
+
+#include "geofence.h"
+
+static const uint32_t GeofenceMagic = 0x314F4547; // "GEO1"
+static const int      VertexBatch   = 16;         // read at a time
+
+Geofence::Geofence(const char *path) : mPath(path), mOpened(false), mAbsent(false), mCell(-1), mCount(0), mZoneIndex(-1) {
+  memset(&mHeader, 0, sizeof(mHeader));
+  memset(&mZone, 0, sizeof(mZone));
+}
+
+// cppcheck-suppress unusedFunction
+void Geofence::begin(const Configuration &conf) {
+  mBase = conf.beacon;
+}
+
+// A missing or bad file is only looked for once, it means no zones.
+bool Geofence::open() {
+  if (mOpened || mAbsent) {
+    return mOpened;
+  }
+  mAbsent = true;
+  if (!ConfigurationManagement::mount()) {
+    return false;
+  }
+  mFile = SPIFFS.open(mPath, FILE_READ);
+  if (!mFile) {
+    return false;
+  }
+  if (mFile.read((uint8_t *)&mHeader, sizeof(mHeader)) != sizeof(mHeader) || mHeader.magic != GeofenceMagic || mHeader.rows == 0 || mHeader.cols == 0 || mHeader.cell_lat <= 0 || mHeader.cell_lng <= 0) {
+    Serial.printf("%s: not a geofence file\n", mPath);
+    mFile.close();
+    return false;
+  }
+  mAbsent = false;
+  mOpened = true;
+  return true;
+}
+
+bool Geofence::readAt(uint32_t offset, void *data, size_t length) {
+  return mFile.seek(offset) && mFile.read((uint8_t *)data, length) == length;
+}
+
+// The fence list of the cell is kept for the next fixes, which are most often
+// in the same one.
+bool Geofence::loadCell(int32_t cell) {
+  if (cell == mCell) {
+    return true;
+  }
+  Cell entry;
+  mCell  = -1;
+  mCount = 0;
+  if (!readAt(sizeof(Header) + mHeader.zones * sizeof(Zone) + mHeader.fences * sizeof(Fence) + cell * sizeof(Cell), &entry, sizeof(entry)) || entry.count > MaxCandidates) {
+    return false;
+  }
+  if (entry.count > 0 && !readAt(entry.offset, mCandidates, entry.count * sizeof(mCandidates[0]))) {
+    return false;
+  }
+  mCell  = cell;
+  mCount = entry.count;
+  return true;
+}
+
+// Crossing number over the edges, in integers: the edge from a to b crosses
+// the parallel of the point east of it when lng < a.lng + (lat - a.lat) *
+// (b.lng - a.lng) / (b.lat - a.lat).
+bool Geofence::contains(const Fence &fence, int32_t lat, int32_t lng) {
+  if (lat < fence.lat_min || lat > fence.lat_max || lng < fence.lng_min || lng > fence.lng_max) {
+    return false;
+  }
+  int32_t vertices[VertexBatch + 1][2];
+  bool    inside = false;
+  // the last vertex closes the polygon
+  if (!readAt(fence.offset + (fence.vertices - 1) * sizeof(vertices[0]), vertices[0], sizeof(vertices[0]))) {
+    return false;
+  }
+  for (uint16_t done = 0; done < fence.vertices;) {
+    uint16_t count = min((uint16_t)VertexBatch, (uint16_t)(fence.vertices - done));
+    if (!readAt(fence.offset + done * sizeof(vertices[0]), vertices[1], count * sizeof(vertices[0]))) {
+      return false;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+      const int32_t *a = vertices[i];
+      const int32_t *b = vertices[i + 1];
+      if ((a[0] > lat) != (b[0] > lat)) {
+        int64_t east  = (int64_t)(lng - a[1]) * (b[0] - a[0]);
+        int64_t cross = (int64_t)(lat - a[0]) * (b[1] - a[1]);
+        if (b[0] > a[0] ? east < cross : east > cross) {
+          inside = !inside;
+        }
+      }
+    }
+    memcpy(vertices[0], vertices[count], sizeof(vertices[0]));
+    done += count;
+  }
+  return inside;
+}
+
+int Geofence::lookup(int32_t lat, int32_t lng) {
+  if (!open()) {
+    return -1;
+  }
+  int64_t row = ((int64_t)lat - mHeader.lat0) / mHeader.cell_lat;
+  int64_t col = ((int64_t)lng - mHeader.lng0) / mHeader.cell_lng;
+  if (lat < mHeader.lat0 || lng < mHeader.lng0 || row >= mHeader.rows || col >= mHeader.cols || !loadCell((int32_t)(row * mHeader.cols + col))) {
+    return -1;
+  }
+  uint32_t fences = sizeof(Header) + mHeader.zones * sizeof(Zone);
+  for (uint16_t i = 0; i < mCount; i++) {
+    Fence fence;
+    if (readAt(fences + mCandidates[i] * sizeof(Fence), &fence, sizeof(fence)) && fence.vertices >= 3 && contains(fence, lat, lng)) {
+      return fence.zone < mHeader.zones ? fence.zone : -1;
+    }
+  }
+  return -1;
+}
+
+// cppcheck-suppress unusedFunction
+bool Geofence::update(double lat_deg, double lng_deg) {
+  int index = lookup(lround(lat_deg * 1e5), lround(lng_deg * 1e5));
+  if (index == mZoneIndex) {
+    return false;
+  }
+  if (index >= 0 && !readAt(sizeof(Header) + index * sizeof(Zone), &mZone, sizeof(mZone))) {
+    return false;
+  }
+  mZoneIndex = index;
+  if (index < 0) {
+    memset(&mZone, 0, sizeof(mZone));
+  }
+  mZone.name[sizeof(mZone.name) - 1]       = '\0';
+  mZone.message[sizeof(mZone.message) - 1] = '\0';
+  return true;
+}
+
+// cppcheck-suppress unusedFunction
+void Geofence::apply(Configuration &conf) const {
+  conf.beacon.smart_beacon.active    = mBase.smart_beacon.active;
+  conf.beacon.smart_beacon.slow_rate = mBase.smart_beacon.slow_rate;
+  conf.beacon.smart_beacon.fast_rate = mBase.smart_beacon.fast_rate;
+  conf.beacon.message                = mBase.message;
+  if (mZoneIndex < 0) {
+    return;
+  }
+  if (mZone.rate > 0) {
+    conf.beacon.smart_beacon.active    = false;
+    conf.beacon.smart_beacon.slow_rate = mZone.rate;
+  }
+  if (mZone.message[0]) {
+    conf.beacon.message = mZone.message;
+  }
+}
+
+// cppcheck-suppress unusedFunction
+void Geofence::print(Print &out) const {
+  if (!mOpened) {
+    return;
+  }
+  if (mZoneIndex < 0) {
+    out.println("Zone       none");
+  } else {
+    out.printf("Zone       %s\n", mZone.name);
+  }
+}
+
+// cppcheck-suppress unusedFunction
+void Geofence::retain(Retained &retained) const {
+  retained.zone   = mZone;
+  retained.index  = mZoneIndex;
+  retained.absent = mAbsent;
+}
+
+// cppcheck-suppress unusedFunction
+void Geofence::resume(const Retained &retained) {
+  mZone      = retained.zone;
+  mZoneIndex = retained.index;
+  mAbsent    = retained.absent;
+}
@@ -0,0 +1,98 @@
+#ifndef GEOFENCE_H_
+#define GEOFENCE_H_
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "configuration.h"
+
+// Zones with their own beacon period and comment, looked up at each fix in a
+// SPIFFS file written by tools/geofence_image.py: the polygons are listed in
+// the cells of a fixed grid over them, and a lookup only reads the cell of
+// the position and the fences it lists. The file stays in flash, the RAM
+// holds its header, the fence list of the last cell and the current zone.
+class Geofence {
+public:
+  explicit Geofence(const char *path);
+
+  // The beacon settings restored when leaving a zone.
+  void begin(const Configuration &conf);
+
+  // Looks up the zone of the position, true when it changed.
+  bool update(double lat_deg, double lng_deg);
+  // The first zone of the file holding the point, -1 in none. Latitude and
+  // longitude in 1e-5 degree.
+  int lookup(int32_t lat, int32_t lng);
+
+  int zone() const {
+    return mZoneIndex;
+  }
+  // Inside a zone with a rate the smart beacon is off and the period is that
+  // rate, a zone with a message replaces the comment.
+  void apply(Configuration &conf) const;
+  void print(Print &out) const;
+
+  static const int MaxCandidates = 32; // fences in a cell
+
+  struct Zone {
+    char    name[16];
+    int32_t rate; // s, 0 keeps the period
+    char    message[48];
+  };
+
+  struct Retained {
+    Zone    zone;
+    int16_t index;
+    bool    absent;
+  };
+  void retain(Retained &retained) const;
+  void resume(const Retained &retained);
+
+private:
+  struct Header {
+    uint32_t magic;
+    uint16_t zones;
+    uint16_t fences;
+    uint16_t rows;
+    uint16_t cols;
+    int32_t  lat0; // south west corner of the grid
+    int32_t  lng0;
+    int32_t  cell_lat;
+    int32_t  cell_lng;
+  };
+
+  struct Fence {
+    uint16_t zone;
+    uint16_t vertices;
+    int32_t  lat_min;
+    int32_t  lat_max;
+    int32_t  lng_min;
+    int32_t  lng_max;
+    uint32_t offset; // of the vertices, latitude then longitude
+  };
+
+  struct Cell {
+    uint32_t offset; // of the fence indexes, increasing
+    uint16_t count;
+    uint16_t reserved;
+  };
+
+  bool open();
+  bool readAt(uint32_t offset, void *data, size_t length);
+  bool loadCell(int32_t cell);
+  bool contains(const Fence &fence, int32_t lat, int32_t lng);
+
+  const char            *mPath;
+  File                   mFile;
+  bool                   mOpened;
+  bool                   mAbsent;
+  Header                 mHeader;
+  int32_t                mCell;
+  uint16_t               mCandidates[MaxCandidates];
+  uint16_t               mCount;
+  int                    mZoneIndex;
+  Zone                   mZone;
+  Configuration::Beacon  mBase;
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include <SPIFFS.h>
+
+#include "configuration.h"
+#include "gps_aiding.h"
+
+static const uint32_t AidingMagic      = 0x32444941; // "AID2"
+static const uint16_t EphemerisLength  = 104;
+static const int      EphemerisCount   = 32;
+// GPS time started 1980-01-06 and is ahead of UTC by the leap seconds.
+static const uint32_t GpsEpoch         = 315964800UL;
+static const uint32_t GpsLeapSeconds   = 18;
+static const uint32_t SecondsPerWeek   = 604800UL;
+static const uint32_t PositionAccuracy = 1000000; // cm, the tracker moved while off
+static const uint32_t TimeAccuracy     = 2000;    // ms, drift of the ESP32 clock over a sleep
+
+static void put_u32(uint8_t *p, uint32_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+}
+
+GpsAiding::GpsAiding(UbxGps &ubx, const char *path) : mUbx(ubx), mPath(path), mHasPosition(false), mSaved(false), mSaved_ms(0), mPending(false), mPendingUtc(0) {
+  memset(&mHeader, 0, sizeof(mHeader));
+}
+
+// cppcheck-suppress unusedFunction
+void GpsAiding::setPosition(long lat_e7, long lng_e7, long alt_cm) {
+  mHeader.lat_e7 = lat_e7;
+  mHeader.lng_e7 = lng_e7;
+  mHeader.alt_cm = alt_cm;
+  mHasPosition   = true;
+}
+
+// cppcheck-suppress unusedFunction
+int GpsAiding::save(unsigned long now_ms, time_t utc) {
+  if (!mHasPosition || (mSaved && now_ms - mSaved_ms < SaveInterval_ms)) {
+    return 0;
+  }
+  mUbx.send(UBX_CLASS_AID, UBX_AID_EPH, NULL, 0);
+  // the receiver answers with one frame per SV, 8 bytes long when it has no
+  // ephemeris for it; the file is only replaced once there is one
+  File file;
+  int  count = 0;
+  for (int i = 0; i < EphemerisCount && mUbx.receive(UBX_CLASS_AID, UBX_AID_EPH); i++) {
+    if (mUbx.parser().length() != EphemerisLength) {
+      continue;
+    }
+    if (!file) {
+      if (!ConfigurationManagement::mount()) {
+        return 0;
+      }
+      file = SPIFFS.open(mPath, FILE_WRITE);
+      if (!file) {
+        return 0;
+      }
+      mHeader.magic = AidingMagic;
+      mHeader.utc   = utc;
+      file.write((const uint8_t *)&mHeader, sizeof(mHeader));
+    }
+    file.write(mUbx.parser().payload(), EphemerisLength);
+    count++;
+  }
+  if (file) {
+    file.close();
+    mSaved    = true;
+    mSaved_ms = now_ms;
+  }
+  return count;
+}
+
+static bool fresh(uint32_t saved, time_t utc) {
+  return saved && (uint32_t)utc >= saved && (uint32_t)utc - saved < GpsAiding::EphemerisValidity_s;
+}
+
+// cppcheck-suppress unusedFunction
+int GpsAiding::restore(time_t utc) {
+  mPending = false;
+  if (!ConfigurationManagement::mount()) {
+    return 0;
+  }
+  File file = SPIFFS.open(mPath, FILE_READ);
+  if (!file) {
+    return 0;
+  }
+  Header header;
+  if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || header.magic != AidingMagic) {
+    file.close();
+    return 0;
+  }
+  if (!mHasPosition) {
+    mHeader      = header;
+    mHasPosition = true;
+  }
+  sendInitial(utc);
+  // the receiver would track with stale orbits, the position alone still
+  // helps; after a reboot their age is known at the first time from the
+  // receiver, see replay()
+  int count = 0;
+  if (!utc) {
+    mPending    = header.utc != 0;
+    mPendingUtc = header.utc;
+  } else if (fresh(header.utc, utc)) {
+    count = sendEphemerides(file);
+  }
+  file.close();
+  return count;
+}
+
+// cppcheck-suppress unusedFunction
+int GpsAiding::replay(time_t utc) {
+  if (!mPending) {
+    return 0;
+  }
+  mPending = false;
+  if (!fresh(mPendingUtc, utc)) {
+    return 0;
+  }
+  File file = SPIFFS.open(mPath, FILE_READ);
+  if (!file) {
+    return 0;
+  }
+  Header header;
+  int    count = 0;
+  if (file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) && header.magic == AidingMagic && header.utc == mPendingUtc) {
+    count = sendEphemerides(file);
+  }
+  file.close();
+  return count;
+}
+
+int GpsAiding::sendEphemerides(File &file) {
+  uint8_t ephemeris[EphemerisLength];
+  int     count = 0;
+  while (file.read(ephemeris, sizeof(ephemeris)) == sizeof(ephemeris)) {
+    mUbx.send(UBX_CLASS_AID, UBX_AID_EPH, ephemeris, sizeof(ephemeris));
+    count++;
+  }
+  return count;
+}
+
+// AID-INI with the position as latitude/longitude/altitude and, when known,
+// the time as GPS week and time of week.
+void GpsAiding::sendInitial(time_t utc) {
+  uint8_t ini[48];
+  memset(ini, 0, sizeof(ini));
+  put_u32(ini, mHeader.lat_e7);
+  put_u32(ini + 4, mHeader.lng_e7);
+  put_u32(ini + 8, mHeader.alt_cm);
+  put_u32(ini + 12, PositionAccuracy);
+  uint32_t flags = 0x21; // pos, lla
+  if (utc > (time_t)GpsEpoch) {
+    uint32_t gps_s = (uint32_t)utc - GpsEpoch + GpsLeapSeconds;
+    uint16_t week  = gps_s / SecondsPerWeek;
+    ini[18]        = week;
+    ini[19]        = week >> 8;
+    put_u32(ini + 20, (gps_s % SecondsPerWeek) * 1000);
+    put_u32(ini + 28, TimeAccuracy);
+    flags |= 0x02; // time
+  }
+  put_u32(ini + 44, flags);
+  mUbx.send(UBX_CLASS_AID, UBX_AID_INI, ini, sizeof(ini));
+}
+
+// cppcheck-suppress unusedFunction
+void GpsAiding::retain(Retained &retained, unsigned long now_ms) const {
+  retained.header       = mHeader;
+  retained.has_position = mHasPosition;
+  retained.saved        = mSaved;
+  retained.saved_age_ms = now_ms - mSaved_ms;
+}
+
+// cppcheck-suppress unusedFunction
+void GpsAiding::resume(const Retained &retained, uint32_t slept_ms) {
+  mHeader      = retained.header;
+  mHasPosition = retained.has_position;
+  mSaved       = retained.saved;
+  mSaved_ms    = 0UL - (retained.saved_age_ms + slept_ms);
+}
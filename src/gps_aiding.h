@@ -0,0 +1,78 @@
+#ifndef GPS_AIDING_H_
+#define GPS_AIDING_H_
+
+#include <Arduino.h>
+#include <FS.h>
+#include <TimeLib.h>
+
+#include "ubx.h"
+
+// Keeps the receiver's ephemerides and last position in a SPIFFS file while
+// its supply is cut, and feeds them back (AID-INI + AID-EPH) on power-up so
+// that the next fix is close to a hot start instead of a warm one.
+class GpsAiding {
+public:
+  GpsAiding(UbxGps &ubx, const char *path);
+
+  // Last fix, saved with the ephemerides. Latitude and longitude in 1e-7
+  // degrees, altitude in cm.
+  void setPosition(long lat_e7, long lng_e7, long alt_cm);
+
+  // Polls AID-EPH and stores the valid ephemerides with utc, at most once
+  // per SaveInterval_ms as they are good for about 4 hours. Returns the
+  // number stored, 0 when nothing was written.
+  int save(unsigned long now_ms, time_t utc);
+
+  // Sends the position, utc when it is not 0, and the stored ephemerides
+  // when they are younger than EphemerisValidity_s. Without utc their age is
+  // unknown and they wait for replay(). Returns the number of ephemerides
+  // sent.
+  int restore(time_t utc);
+
+  // Sends the ephemerides left out by restore(0) once utc is known, when
+  // they are still fresh. Returns the number sent, 0 when none are waiting.
+  int replay(time_t utc);
+  bool pending() const {
+    return mPending;
+  }
+
+  static const unsigned long SaveInterval_ms     = 30UL * 60 * 1000;
+  static const uint32_t      EphemerisValidity_s = 4UL * 3600;
+
+private:
+  struct Header {
+    uint32_t magic;
+    int32_t  lat_e7;
+    int32_t  lng_e7;
+    int32_t  alt_cm;
+    uint32_t utc; // of the save, 0 when unknown
+  };
+
+public:
+  // Last position and save time kept over a deep sleep, see
+  // SmartBeacon::Retained.
+  struct Retained {
+    Header   header;
+    bool     has_position;
+    bool     saved;
+    uint32_t saved_age_ms;
+  };
+  void retain(Retained &retained, unsigned long now_ms) const;
+  void resume(const Retained &retained, uint32_t slept_ms);
+
+private:
+
+  void sendInitial(time_t utc);
+  int  sendEphemerides(File &file);
+
+  UbxGps       &mUbx;
+  const char   *mPath;
+  Header        mHeader;
+  bool          mHasPosition;
+  bool          mSaved;
+  unsigned long mSaved_ms;
+  bool          mPending; // ephemerides of unknown age after restore(0)
+  uint32_t      mPendingUtc;
+};
+
+#endif
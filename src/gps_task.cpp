@@ -0,0 +1,102 @@
+#include "gps_task.h"
+
+#define GPS_TASK_CORE  0
+#define GPS_TASK_STACK 3072
+#define GPS_TASK_POLL  10 // ms, the UART buffer holds seconds
+
+// cppcheck-suppress uninitMemberVar
+GpsTask::GpsTask(NmeaReader &reader, TinyGPSPlus &gps) : mReader(reader), mGps(gps), mDropped(0) {
+#ifndef NATIVE
+  mUart = NULL;
+#endif
+}
+
+// cppcheck-suppress unusedFunction
+void GpsTask::begin() {
+#ifndef NATIVE
+  mUart = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(task, "gps", GPS_TASK_STACK, this, 2, NULL, GPS_TASK_CORE);
+#endif
+}
+
+#ifndef NATIVE
+void GpsTask::task(void *arg) {
+  GpsTask *self = (GpsTask *)arg;
+  while (true) {
+    xSemaphoreTake(self->mUart, portMAX_DELAY);
+    self->step();
+    xSemaphoreGive(self->mUart);
+    vTaskDelay(pdMS_TO_TICKS(GPS_TASK_POLL));
+  }
+}
+#endif
+
+// cppcheck-suppress unusedFunction
+void GpsTask::hold() {
+#ifndef NATIVE
+  if (mUart) {
+    xSemaphoreTake(mUart, portMAX_DELAY);
+  }
+#endif
+}
+
+// cppcheck-suppress unusedFunction
+void GpsTask::release() {
+#ifndef NATIVE
+  if (mUart) {
+    xSemaphoreGive(mUart);
+  }
+#endif
+}
+
+void GpsTask::step() {
+  if (!mReader.poll()) {
+    return;
+  }
+  GpsFix fix;
+  fix.epoch_ms       = mReader.epoch_ms();
+  fix.time_valid     = mGps.time.isValid() && mGps.date.value() != 0;
+  fix.year           = mGps.date.year();
+  fix.month          = mGps.date.month();
+  fix.day            = mGps.date.day();
+  fix.hour           = mGps.time.hour();
+  fix.minute         = mGps.time.minute();
+  fix.second         = mGps.time.second();
+  fix.location_valid = mGps.location.isValid();
+  fix.location_fresh = fix.location_valid && mGps.location.age() < NmeaReader::Epoch_ms;
+  fix.lat            = mGps.location.rawLat();
+  fix.lng            = mGps.location.rawLng();
+  fix.lat_deg        = mGps.location.lat();
+  fix.lng_deg        = mGps.location.lng();
+  fix.altitude_m     = mGps.altitude.meters();
+  fix.speed_kmph     = mGps.speed.kmph();
+  fix.speed_knots    = mGps.speed.knots();
+  fix.course_deg     = mGps.course.deg();
+  fix.satellites     = mGps.satellites.value();
+  fix.hdop           = mGps.hdop.value();
+  if (!mQueue.push(fix)) {
+    mDropped++;
+  }
+}
+
+// cppcheck-suppress unusedFunction
+bool GpsTask::receive(GpsFix &fix) {
+#ifdef NATIVE
+  step();
+#endif
+  bool received = false;
+  while (mQueue.pop(fix)) {
+    received = true;
+  }
+  return received;
+}
+
+// cppcheck-suppress unusedFunction
+void GpsTask::reset() {
+  GpsFix stale;
+  hold();
+  mReader.reset();
+  while (mQueue.pop(stale)) {
+  }
+  release();
+}
@@ -0,0 +1,75 @@
+#ifndef GPS_TASK_H_
+#define GPS_TASK_H_
+
+#include <Arduino.h>
+#include <TinyGPS++.h>
+
+#include "nmea_reader.h"
+#include "spsc_queue.h"
+
+// What loop() needs of one RMC + GGA burst, copied out of TinyGPS++ by the
+// GPS task. Like TinyGPS++ it keeps the last position when the burst has
+// none.
+struct GpsFix {
+  unsigned long epoch_ms;       // millis() when the RMC of the burst came in
+  bool          time_valid;     // date and time below
+  uint16_t      year;
+  uint8_t       month;
+  uint8_t       day;
+  uint8_t       hour;
+  uint8_t       minute;
+  uint8_t       second;
+  bool          location_valid; // there was a fix once
+  bool          location_fresh; // and it is from this burst
+  RawDegrees    lat;
+  RawDegrees    lng;
+  double        lat_deg;
+  double        lng_deg;
+  double        altitude_m;
+  double        speed_kmph;
+  double        speed_knots;
+  double        course_deg;
+  uint32_t      satellites;
+  int32_t       hdop; // hundredths
+};
+
+// Reads the receiver on core 0 so that loop() can block on the display or a
+// transmission without the UART buffer overflowing, and hands each burst over
+// through a lock-free queue. The UBX exchanges of loop() on the same UART
+// happen between hold() and release(). On the native build there is no task,
+// receive() reads the UART itself.
+class GpsTask {
+public:
+  GpsTask(NmeaReader &reader, TinyGPSPlus &gps);
+
+  void begin();
+  // Blocks until the task is off the UART, and gives it back.
+  void hold();
+  void release();
+  // Latest burst since the previous call, false when there is none.
+  bool receive(GpsFix &fix);
+  // Forgets the receiver timing and the bursts not received yet, after a
+  // sleep or a power-up.
+  void reset();
+
+  uint32_t dropped() const {
+    return mDropped;
+  }
+
+private:
+  static const size_t QueueSize = 8; // seconds of bursts, longer than an SF12 frame
+
+  void step();
+#ifndef NATIVE
+  static void task(void *arg);
+
+  SemaphoreHandle_t mUart;
+#endif
+
+  NmeaReader                    &mReader;
+  TinyGPSPlus                   &mGps;
+  SpscQueue<GpsFix, QueueSize>   mQueue;
+  volatile uint32_t              mDropped;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "listen_before_talk.h"
+
+// SX1276/77/78 registers, as in the LoRa library
+#define REG_OP_MODE   0x01
+#define REG_IRQ_FLAGS 0x12
+
+#define MODE_LONG_RANGE_MODE 0x80
+#define MODE_STDBY           0x01
+#define MODE_CAD             0x07
+
+#define IRQ_CAD_DONE_MASK     0x04
+#define IRQ_CAD_DETECTED_MASK 0x01
+
+ListenBeforeTalk::ListenBeforeTalk(int cs_pin) : mCs(cs_pin), mActive(false), mSymbol_us(0), mMaxDefer_ms(0), mStart_ms(0), mDeferred(false), mCads(0), mBusy(0), mAvoided(0), mForced(0) {
+}
+
+// cppcheck-suppress unusedFunction
+void ListenBeforeTalk::begin(const Configuration::LoRa &lora) {
+  mActive      = lora.listenBeforeTalk;
+  mSymbol_us   = (uint32_t)((1000000ULL << lora.spreadingFactor) / lora.signalBandwidth);
+  mMaxDefer_ms = lora.maxDefer * 1000UL;
+}
+
+// cppcheck-suppress unusedFunction
+void ListenBeforeTalk::start() {
+  mStart_ms = millis();
+  mDeferred = false;
+}
+
+// cppcheck-suppress unusedFunction
+uint32_t ListenBeforeTalk::busy(uint32_t time_on_air_us) {
+  if (!mActive) {
+    return 0;
+  }
+  mCads++;
+  if (!detect()) {
+    if (mDeferred) {
+      mAvoided++;
+    }
+    return 0;
+  }
+  mBusy++;
+  unsigned long waited = millis() - mStart_ms;
+  if (waited >= mMaxDefer_ms) {
+    mForced++;
+    return 0;
+  }
+  mDeferred            = true;
+  uint32_t time_on_air = time_on_air_us / 1000;
+  uint32_t backoff     = random(time_on_air / 2, time_on_air * 3 / 2 + 1);
+  return (uint32_t)max(1UL, min((unsigned long)backoff, mMaxDefer_ms - waited));
+}
+
+bool ListenBeforeTalk::detect() {
+  writeRegister(REG_IRQ_FLAGS, IRQ_CAD_DONE_MASK | IRQ_CAD_DETECTED_MASK);
+  writeRegister(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_CAD);
+  // a CAD lasts about two symbols, then the radio is back in standby
+  unsigned long timeout = 4 * mSymbol_us / 1000 + 10;
+  unsigned long start   = millis();
+  uint8_t       flags;
+  while (!((flags = readRegister(REG_IRQ_FLAGS)) & IRQ_CAD_DONE_MASK) && millis() - start < timeout) {
+    delay(1);
+  }
+  writeRegister(REG_IRQ_FLAGS, IRQ_CAD_DONE_MASK | IRQ_CAD_DETECTED_MASK);
+  writeRegister(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_STDBY);
+  return (flags & IRQ_CAD_DONE_MASK) && (flags & IRQ_CAD_DETECTED_MASK);
+}
+
+uint8_t ListenBeforeTalk::readRegister(uint8_t address) {
+  SPI.beginTransaction(SPISettings(8E6, MSBFIRST, SPI_MODE0));
+  digitalWrite(mCs, LOW);
+  SPI.transfer(address & 0x7f);
+  uint8_t value = SPI.transfer(0x00);
+  digitalWrite(mCs, HIGH);
+  SPI.endTransaction();
+  return value;
+}
+
+void ListenBeforeTalk::writeRegister(uint8_t address, uint8_t value) {
+  SPI.beginTransaction(SPISettings(8E6, MSBFIRST, SPI_MODE0));
+  digitalWrite(mCs, LOW);
+  SPI.transfer(address | 0x80);
+  SPI.transfer(value);
+  digitalWrite(mCs, HIGH);
+  SPI.endTransaction();
+}
+
+// cppcheck-suppress unusedFunction
+void ListenBeforeTalk::reset() {
+  mCads    = 0;
+  mBusy    = 0;
+  mAvoided = 0;
+  mForced  = 0;
+}
+
+// cppcheck-suppress unusedFunction
+void ListenBeforeTalk::print(Print &out) {
+  if (!mActive) {
+    return;
+  }
+  out.printf("CAD        %u, busy %u, beacons deferred to a clear channel %u, sent after max_defer %u\n", mCads, mBusy, mAvoided, mForced);
+}
+
+// cppcheck-suppress unusedFunction
+void ListenBeforeTalk::retain(Retained &retained) const {
+  retained.cads    = mCads;
+  retained.busy    = mBusy;
+  retained.avoided = mAvoided;
+  retained.forced  = mForced;
+}
+
+// cppcheck-suppress unusedFunction
+void ListenBeforeTalk::resume(const Retained &retained) {
+  mCads    = retained.cads;
+  mBusy    = retained.busy;
+  mAvoided = retained.avoided;
+  mForced  = retained.forced;
+}
@@ -0,0 +1,53 @@
+#ifndef LISTEN_BEFORE_TALK_H_
+#define LISTEN_BEFORE_TALK_H_
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include "configuration.h"
+
+// Channel Activity Detection on the transmit frequency before a beacon goes
+// out. While another LoRa preamble is heard the beacon waits a random backoff
+// of half to one and a half of its own time on air, and is sent anyway once
+// it has waited max_defer. The LoRa library has no CAD call, so the SX127x
+// mode and IRQ flag registers are driven here the way the library does it.
+class ListenBeforeTalk {
+public:
+  explicit ListenBeforeTalk(int cs_pin);
+
+  void begin(const Configuration::LoRa &lora);
+  // Before the first busy() of a beacon.
+  void start();
+  // 0 when the beacon can go now, otherwise ms to wait before asking again.
+  uint32_t busy(uint32_t time_on_air_us);
+
+  void reset();
+  void print(Print &out);
+
+  struct Retained {
+    uint32_t cads;
+    uint32_t busy;
+    uint32_t avoided;
+    uint32_t forced;
+  };
+  void retain(Retained &retained) const;
+  void resume(const Retained &retained);
+
+private:
+  bool    detect();
+  uint8_t readRegister(uint8_t address);
+  void    writeRegister(uint8_t address, uint8_t value);
+
+  int           mCs;
+  bool          mActive;
+  uint32_t      mSymbol_us;
+  unsigned long mMaxDefer_ms;
+  unsigned long mStart_ms;
+  bool          mDeferred;
+  uint32_t      mCads;
+  uint32_t      mBusy;
+  uint32_t      mAvoided; // deferred, then sent on a clear channel
+  uint32_t      mForced;  // sent on a busy channel after max_defer
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "nmea_reader.h"
+
+NmeaReader::NmeaReader(Stream &port, TinyGPSPlus &gps) : mPort(port), mGps(gps), mLength(0), mHasRmc(false), mEpoch_ms(0) {
+}
+
+// cppcheck-suppress unusedFunction
+bool NmeaReader::poll() {
+  bool complete = false;
+  while (mPort.available() > 0) {
+    char c = mPort.read();
+    if (c == '$') {
+      mLength = 0;
+    } else if (c == '\n') {
+      if (mLength > 0 && mLength < sizeof(mLine)) {
+        mLine[mLength] = '\0';
+        complete       = sentence() || complete;
+      }
+      mLength = 0;
+      continue;
+    }
+    if (mLength < sizeof(mLine)) {
+      mLine[mLength++] = c;
+    } else {
+      mLength = 0;
+    }
+  }
+  return complete;
+}
+
+// $xxRMC and $xxGGA whatever the talker (GP, GN, ...), the rest is dropped
+// without parsing. true when it is the GGA that ends a burst.
+bool NmeaReader::sentence() {
+  if (mLength < 7 || mLine[0] != '$') {
+    return false;
+  }
+  const char *type = mLine + 3;
+  bool        rmc  = strncmp(type, "RMC,", 4) == 0;
+  if (!rmc && strncmp(type, "GGA,", 4) != 0) {
+    return false;
+  }
+  for (const char *p = mLine; *p; p++) {
+    mGps.encode(*p);
+  }
+  mGps.encode('\n');
+  if (rmc) {
+    mHasRmc   = true;
+    mEpoch_ms = millis();
+    return false;
+  }
+  bool complete = mHasRmc;
+  mHasRmc       = false;
+  return complete;
+}
+
+// cppcheck-suppress unusedFunction
+uint32_t NmeaReader::quiet_ms(unsigned long epoch_ms, unsigned long now_ms) {
+  unsigned long elapsed = now_ms - epoch_ms;
+  if (elapsed + Margin_ms >= Epoch_ms) {
+    return 0;
+  }
+  return Epoch_ms - Margin_ms - elapsed;
+}
+
+// cppcheck-suppress unusedFunction
+void NmeaReader::reset() {
+  mLength = 0;
+  mHasRmc = false;
+}
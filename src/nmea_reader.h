@@ -0,0 +1,41 @@
+#ifndef NMEA_READER_H_
+#define NMEA_READER_H_
+
+#include <Arduino.h>
+#include <TinyGPS++.h>
+
+// Takes the receiver output sentence by sentence out of the UART driver's
+// buffer and hands only RMC and GGA to TinyGPS++. The receiver sends one
+// burst per second starting with RMC, so once the GGA of a burst is in the
+// UART stays idle until the next one and the CPU can light sleep meanwhile.
+class NmeaReader {
+public:
+  NmeaReader(Stream &port, TinyGPSPlus &gps);
+
+  // Reads what is buffered, true when it completed a burst.
+  bool poll();
+  // millis() when the RMC of the last burst came in.
+  unsigned long epoch_ms() const {
+    return mEpoch_ms;
+  }
+  // ms to sleep before the burst after the one that started at epoch_ms, 0
+  // when it is too close.
+  static uint32_t quiet_ms(unsigned long epoch_ms, unsigned long now_ms);
+  // Forgets the timing and any partial sentence, after a sleep or power-up.
+  void reset();
+
+  static const uint32_t Epoch_ms  = 1000;
+  static const uint32_t Margin_ms = 150;
+
+private:
+  bool sentence();
+
+  Stream       &mPort;
+  TinyGPSPlus  &mGps;
+  char          mLine[96];
+  size_t        mLength;
+  bool          mHasRmc;
+  unsigned long mEpoch_ms;
+};
+
+#endif
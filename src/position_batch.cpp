@@ -0,0 +1,108 @@
+#include "position_batch.h"
+
+PositionBatch::PositionBatch() : mSize(0), mCount(0), mNext(0) {
+  memset(mFixes, 0, sizeof(mFixes));
+}
+
+// cppcheck-suppress unusedFunction
+void PositionBatch::begin(int size) {
+  mSize = (size_t)max(0, min(size, (int)Capacity - 1));
+}
+
+// cppcheck-suppress unusedFunction
+void PositionBatch::add(time_t utc, double lat_deg, double lng_deg) {
+  if (!mSize) {
+    return;
+  }
+  Fix &fix = mFixes[mNext];
+  fix.utc  = (uint32_t)utc;
+  fix.lat  = lround(lat_deg * 1e5);
+  fix.lng  = lround(lng_deg * 1e5);
+  mNext    = (mNext + 1) % Capacity;
+  mCount   = min(mCount + 1, (size_t)Capacity);
+}
+
+size_t PositionBatch::count() const {
+  return mCount ? mCount - 1 : 0;
+}
+
+// age 0 is the newest
+const PositionBatch::Fix &PositionBatch::newest(size_t age) const {
+  return mFixes[(mNext + Capacity - 1 - age) % Capacity];
+}
+
+// fix against the later one as the three base 91 values, false when one
+// does not fit its 2 characters
+bool PositionBatch::delta(const Fix &later, const Fix &fix, uint32_t values[3]) {
+  int64_t dt   = (int64_t)later.utc - fix.utc;
+  int64_t dlat = (int64_t)fix.lat - later.lat + Offset;
+  int64_t dlng = (int64_t)fix.lng - later.lng + Offset;
+  if (dt < 0 || dt > 2 * Offset || dlat < 0 || dlat > 2 * Offset || dlng < 0 || dlng > 2 * Offset) {
+    return false;
+  }
+  values[0] = (uint32_t)dt;
+  values[1] = (uint32_t)dlat;
+  values[2] = (uint32_t)dlng;
+  return true;
+}
+
+// True when the characters from start complete a DAO "!xyz!" or an altitude
+// "/A=", which APRS parsers look for anywhere in the comment.
+bool PositionBatch::misread(const char *text, size_t start, size_t end) {
+  for (size_t i = start; i < end; i++) {
+    if (text[i] == '!' && i >= 4 && text[i - 4] == '!') {
+      return true;
+    }
+    if (text[i] == '=' && i >= 2 && text[i - 1] == 'A' && text[i - 2] == '/') {
+      return true;
+    }
+  }
+  return false;
+}
+
+// cppcheck-suppress unusedFunction
+size_t PositionBatch::append(FrameBuilder &frame, size_t limit) const {
+  size_t       fixes = min(min(limit, count()), mSize);
+  uint32_t     values[3];
+  char         text[6 * Capacity + 1];
+  FrameBuilder encoded(text, sizeof(text));
+  size_t       sent = 0;
+  while (sent < fixes && delta(newest(sent), newest(sent + 1), values)) {
+    size_t start = encoded.length();
+    encoded.appendBase91(values[0], 2).appendBase91(values[1], 2).appendBase91(values[2], 2);
+    if (misread(text, start, encoded.length())) {
+      break;
+    }
+    sent++;
+  }
+  if (!sent) {
+    return 0;
+  }
+  text[6 * sent] = '\0';
+  frame.append('}').append(text).append('}');
+  return sent;
+}
+
+// cppcheck-suppress unusedFunction
+void PositionBatch::clear() {
+  mCount = 0;
+}
+
+// cppcheck-suppress unusedFunction
+size_t PositionBatch::encodedLength(size_t fixes) {
+  return fixes ? 2 + 6 * fixes : 0;
+}
+
+// cppcheck-suppress unusedFunction
+void PositionBatch::retain(Retained &retained) const {
+  memcpy(retained.fixes, mFixes, sizeof(mFixes));
+  retained.count = mCount;
+  retained.next  = mNext;
+}
+
+// cppcheck-suppress unusedFunction
+void PositionBatch::resume(const Retained &retained) {
+  memcpy(mFixes, retained.fixes, sizeof(mFixes));
+  mCount = min((size_t)retained.count, (size_t)Capacity);
+  mNext  = retained.next % Capacity;
+}
@@ -0,0 +1,64 @@
+#ifndef POSITION_BATCH_H_
+#define POSITION_BATCH_H_
+
+#include <Arduino.h>
+#include <TimeLib.h>
+
+#include "frame_builder.h"
+
+// Fixes recorded since the last beacon, sent with the next one after its
+// position as "}", 6 base 91 characters per fix and "}". Each fix, newest
+// first, is given against the one sent before it (the position of the frame
+// for the first): seconds earlier, then latitude and longitude changes in
+// 1e-5 degree, each offset by 4140 in 2 characters. A fix that does not fit
+// ends the list, and so does one whose characters would read as a DAO or an
+// altitude extension. tools/batch_decode.py turns a frame back into its fixes.
+class PositionBatch {
+public:
+  static const size_t Capacity = 32;
+
+  PositionBatch();
+
+  // size is the most fixes sent with a beacon, 0 records none.
+  void   begin(int size);
+  size_t size() const {
+    return mSize;
+  }
+  void   add(time_t utc, double lat_deg, double lng_deg);
+  // Fixes recorded before the newest one, the position of the beacon.
+  size_t count() const;
+  // Appends at most limit of them, returns how many went in.
+  size_t append(FrameBuilder &frame, size_t limit) const;
+  void   clear();
+
+  static size_t encodedLength(size_t fixes);
+
+  struct Fix {
+    uint32_t utc;
+    int32_t  lat; // 1e-5 degree
+    int32_t  lng;
+  };
+
+  // The fixes as kept over a deep sleep, see SmartBeacon::Retained.
+  struct Retained {
+    Fix     fixes[Capacity];
+    uint8_t count;
+    uint8_t next;
+  };
+  void retain(Retained &retained) const;
+  void resume(const Retained &retained);
+
+private:
+  static const int32_t Offset = 4140; // 91 * 91 / 2
+
+  static bool delta(const Fix &later, const Fix &fix, uint32_t values[3]);
+  static bool misread(const char *text, size_t start, size_t end);
+  const Fix  &newest(size_t age) const;
+
+  size_t mSize;
+  Fix    mFixes[Capacity];
+  size_t mCount;
+  size_t mNext;
+};
+
+#endif
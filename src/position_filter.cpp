@@ -0,0 +1,192 @@
+#include "position_filter.h"
+
+static const double MetersPerDegree = 111320.0;
+static const float  Uere_m          = 5.0f;  // position error at HDOP 1
+static const float  StillSpeed      = 0.5f;  // m/s, slower is stopped
+static const float  StillDrift      = 0.02f; // m/s, velocity error while stopped
+static const float  MovingDrift     = 0.5f;  // m/s, velocity error while moving
+static const float  VelocityGain    = 0.5f;  // of a new Doppler velocity
+static const float  Gate            = 18.0f; // 3 sigma squared on both axes
+static const int    MaxRejected     = 3;
+
+static RawDegrees raw_degrees(double value) {
+  RawDegrees raw;
+  raw.negative   = value < 0;
+  value          = fabs(value);
+  raw.deg        = (uint16_t)value;
+  raw.billionths = (uint32_t)min(999999999.0, round((value - raw.deg) * 1e9));
+  return raw;
+}
+
+PositionFilter::PositionFilter()
+    : mActive(false), mMaxHdop(0), mMinDistance_m(0), mMaxSkip(0), mValid(false), mLat(0), mLng(0), mVariance(0), mNorth(0), mEast(0), mCourse(0), mFix_ms(0), mRejected(0), mSentValid(false), mSentLat(0), mSentLng(0), mSkipped(0), mOutliers(0), mSuppressed(0) {
+}
+
+// cppcheck-suppress unusedFunction
+void PositionFilter::begin(const Configuration::Beacon &beacon) {
+  mActive        = beacon.filter;
+  mMaxHdop       = beacon.max_hdop;
+  mMinDistance_m = beacon.min_distance;
+  mMaxSkip       = beacon.max_skip;
+}
+
+// Equirectangular, right to a few meters over the distances compared here.
+float PositionFilter::distance_m(double lat1, double lng1, double lat2, double lng2) {
+  double north = (lat2 - lat1) * MetersPerDegree;
+  double east  = (lng2 - lng1) * MetersPerDegree * cos((lat1 + lat2) / 2 * DEG_TO_RAD);
+  return (float)sqrt(north * north + east * east);
+}
+
+void PositionFilter::start(const GpsFix &fix) {
+  float error = fix.hdop / 100.0f * Uere_m;
+  mValid      = true;
+  mLat        = fix.lat_deg;
+  mLng        = fix.lng_deg;
+  mVariance   = max(1.0f, error * error);
+  mNorth      = fix.speed_kmph / 3.6 * cos(fix.course_deg * DEG_TO_RAD);
+  mEast       = fix.speed_kmph / 3.6 * sin(fix.course_deg * DEG_TO_RAD);
+  mCourse     = fix.course_deg;
+  mFix_ms     = fix.epoch_ms;
+  mRejected   = 0;
+}
+
+// cppcheck-suppress unusedFunction
+bool PositionFilter::update(GpsFix &fix) {
+  if (!mActive) {
+    // only kept for suppress()
+    mValid = true;
+    mLat   = fix.lat_deg;
+    mLng   = fix.lng_deg;
+    return true;
+  }
+  // a poor fix is never a position, nor a reason to start again
+  if (mMaxHdop > 0 && fix.hdop > mMaxHdop * 100) {
+    mOutliers++;
+    return false;
+  }
+  float error = fix.hdop / 100.0f * Uere_m;
+  float noise = max(1.0f, error * error);
+  if (!mValid) {
+    start(fix);
+  } else {
+    // predict with the last velocity, its error grows with the time since
+    float  dt     = (fix.epoch_ms - mFix_ms) / 1000.0f;
+    bool   still  = sqrt(mNorth * mNorth + mEast * mEast) < StillSpeed;
+    float  drift  = (still ? StillDrift : MovingDrift) * dt;
+    double cosLat = cos(mLat * DEG_TO_RAD);
+    double lat    = mLat + mNorth * dt / MetersPerDegree;
+    double lng    = mLng + mEast * dt / (MetersPerDegree * cosLat);
+    float  prior  = mVariance + drift * drift;
+
+    float north = (fix.lat_deg - lat) * MetersPerDegree;
+    float east  = (fix.lng_deg - lng) * MetersPerDegree * cosLat;
+    if (north * north + east * east > Gate * (prior + noise)) {
+      mOutliers++;
+      if (++mRejected < MaxRejected) {
+        return false;
+      }
+      start(fix);
+    } else {
+      float gain = prior / (prior + noise);
+      mLat       = lat + gain * (fix.lat_deg - lat);
+      mLng       = lng + gain * (fix.lng_deg - lng);
+      mVariance  = (1 - gain) * prior;
+      // a Doppler velocity of long ago says nothing of this one
+      float velocityGain = dt > 2.0f ? 1.0f : VelocityGain;
+      float speed        = fix.speed_kmph / 3.6;
+      mNorth += velocityGain * (speed * cos(fix.course_deg * DEG_TO_RAD) - mNorth);
+      mEast += velocityGain * (speed * sin(fix.course_deg * DEG_TO_RAD) - mEast);
+      mFix_ms   = fix.epoch_ms;
+      mRejected = 0;
+    }
+  }
+
+  float speed = sqrt(mNorth * mNorth + mEast * mEast);
+  if (speed >= StillSpeed) {
+    mCourse = atan2(mEast, mNorth) * RAD_TO_DEG;
+    if (mCourse < 0) {
+      mCourse += 360;
+    }
+  } else {
+    speed = 0;
+  }
+  fix.lat_deg     = mLat;
+  fix.lng_deg     = mLng;
+  fix.lat         = raw_degrees(mLat);
+  fix.lng         = raw_degrees(mLng);
+  fix.speed_kmph  = speed * 3.6;
+  fix.speed_knots = speed * 3.6 / 1.852;
+  fix.course_deg  = mCourse;
+  return true;
+}
+
+// cppcheck-suppress unusedFunction
+bool PositionFilter::suppress() {
+  if (mMinDistance_m <= 0 || !mSentValid || !mValid || mSkipped >= mMaxSkip) {
+    return false;
+  }
+  if (distance_m(mSentLat, mSentLng, mLat, mLng) >= mMinDistance_m) {
+    return false;
+  }
+  mSkipped++;
+  mSuppressed++;
+  return true;
+}
+
+// cppcheck-suppress unusedFunction
+void PositionFilter::sent() {
+  mSentValid = mValid;
+  mSentLat   = mLat;
+  mSentLng   = mLng;
+  mSkipped   = 0;
+}
+
+// cppcheck-suppress unusedFunction
+void PositionFilter::reset() {
+  mOutliers   = 0;
+  mSuppressed = 0;
+}
+
+// cppcheck-suppress unusedFunction
+void PositionFilter::print(Print &out) {
+  if (!mActive) {
+    return;
+  }
+  out.printf("Filter     %u outliers, %u beacons skipped within %.0f m\n", (unsigned)mOutliers, (unsigned)mSuppressed, mMinDistance_m);
+}
+
+// cppcheck-suppress unusedFunction
+void PositionFilter::retain(Retained &retained, unsigned long now_ms) const {
+  retained.valid      = mValid;
+  retained.lat        = mLat;
+  retained.lng        = mLng;
+  retained.variance   = mVariance;
+  retained.north      = mNorth;
+  retained.east       = mEast;
+  retained.course     = mCourse;
+  retained.fix_age_ms = now_ms - mFix_ms;
+  retained.sent_valid = mSentValid;
+  retained.sent_lat   = mSentLat;
+  retained.sent_lng   = mSentLng;
+  retained.skipped    = mSkipped;
+  retained.outliers   = mOutliers;
+  retained.suppressed = mSuppressed;
+}
+
+// cppcheck-suppress unusedFunction
+void PositionFilter::resume(const Retained &retained, uint32_t slept_ms) {
+  mValid      = retained.valid;
+  mLat        = retained.lat;
+  mLng        = retained.lng;
+  mVariance   = retained.variance;
+  mNorth      = retained.north;
+  mEast       = retained.east;
+  mCourse     = retained.course;
+  mFix_ms     = 0UL - (retained.fix_age_ms + slept_ms);
+  mSentValid  = retained.sent_valid;
+  mSentLat    = retained.sent_lat;
+  mSentLng    = retained.sent_lng;
+  mSkipped    = retained.skipped;
+  mOutliers   = retained.outliers;
+  mSuppressed = retained.suppressed;
+}
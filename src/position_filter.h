@@ -0,0 +1,80 @@
+#ifndef POSITION_FILTER_H_
+#define POSITION_FILTER_H_
+
+#include <Arduino.h>
+
+#include "configuration.h"
+#include "gps_task.h"
+
+// Smooths the fixes before they are sent: a Kalman filter on the position,
+// with the receiver's Doppler velocity as the motion between two fixes, and
+// the speed and course averaged over the last fixes. The course is held while
+// stopped, where the receiver gives noise. A fix past max_hdop is dropped. A
+// fix too far from the estimate for its HDOP is an outlier, after three in a
+// row the filter starts again from the new position.
+//
+// It also keeps the position of the last beacon: a beacon closer than
+// min_distance to it is skipped, at most max_skip times in a row.
+class PositionFilter {
+public:
+  PositionFilter();
+
+  void begin(const Configuration::Beacon &beacon);
+  // Replaces the position, speed and course of a fresh fix by the estimate.
+  // False for an outlier, the fix is then left as it is. When the filter is
+  // off the fix is only kept for suppress().
+  bool update(GpsFix &fix);
+  // True when the beacon for the estimate is skipped.
+  bool suppress();
+  void sent();
+
+  void reset();
+  void print(Print &out);
+
+  static float distance_m(double lat1, double lng1, double lat2, double lng2);
+
+  // Estimate and counters kept over a deep sleep, see SmartBeacon::Retained.
+  struct Retained {
+    bool     valid;
+    double   lat;
+    double   lng;
+    float    variance;
+    float    north;
+    float    east;
+    float    course;
+    uint32_t fix_age_ms;
+    bool     sent_valid;
+    double   sent_lat;
+    double   sent_lng;
+    int      skipped;
+    uint32_t outliers;
+    uint32_t suppressed;
+  };
+  void retain(Retained &retained, unsigned long now_ms) const;
+  void resume(const Retained &retained, uint32_t slept_ms);
+
+private:
+  void start(const GpsFix &fix);
+
+  bool          mActive;
+  float         mMaxHdop;
+  float         mMinDistance_m;
+  int           mMaxSkip;
+  bool          mValid;
+  double        mLat;
+  double        mLng;
+  float         mVariance; // m2, of each axis
+  float         mNorth;    // m/s
+  float         mEast;
+  float         mCourse;
+  unsigned long mFix_ms;
+  int           mRejected; // outliers in a row
+  bool          mSentValid;
+  double        mSentLat;
+  double        mSentLng;
+  int           mSkipped;
+  uint32_t      mOutliers;
+  uint32_t      mSuppressed;
+};
+
+#endif
@@ -1,7 +1,154 @@
-//Sensor.h
+//Sensor.cpp
 //for lora APRS BEACON
 //Xynium 03 2023
 
+#include <TimeLib.h>
+
 #include "sensor.h"
 
-Adafruit_BMP280 bmp280;
\ No newline at end of file
+// T# analog values are 0..255, sent as value = b * x + c
+static const float PressureStep    = 0.8f; // hPa, from 900
+static const float TemperatureStep = 0.4f; // degrees C, from -40
+static const float BatteryStep     = 0.02f; // V
+
+static Adafruit_BMP280::sensor_sampling sampling(int oversampling) {
+  switch (oversampling) {
+    case 2:
+      return Adafruit_BMP280::SAMPLING_X2;
+    case 4:
+      return Adafruit_BMP280::SAMPLING_X4;
+    case 8:
+      return Adafruit_BMP280::SAMPLING_X8;
+    case 16:
+      return Adafruit_BMP280::SAMPLING_X16;
+    default:
+      return Adafruit_BMP280::SAMPLING_X1;
+  }
+}
+
+static Adafruit_BMP280::sensor_filter filter(int coefficient) {
+  switch (coefficient) {
+    case 2:
+      return Adafruit_BMP280::FILTER_X2;
+    case 4:
+      return Adafruit_BMP280::FILTER_X4;
+    case 8:
+      return Adafruit_BMP280::FILTER_X8;
+    case 16:
+      return Adafruit_BMP280::FILTER_X16;
+    default:
+      return Adafruit_BMP280::FILTER_OFF;
+  }
+}
+
+static unsigned int analog(float value, float from, float step) {
+  return (unsigned int)max(0L, min(255L, lround((value - from) / step)));
+}
+
+Sensor::Sensor(TwoWire &wire) : mBmp(&wire), mActive(false), mCount(0), mPressureSum(0), mTemperatureSum(0), mReport_ms(0), mSequence(0), mReported(false) {
+}
+
+// The temperature only serves the pressure compensation, x1 is enough.
+// cppcheck-suppress unusedFunction
+bool Sensor::begin(const Configuration::Telemetry &telemetry) {
+  mConfig = telemetry;
+  mActive = telemetry.active && mBmp.begin(BMP280_I2C_ADDRESS);
+  if (mActive) {
+    mBmp.setSampling(Adafruit_BMP280::MODE_FORCED, Adafruit_BMP280::SAMPLING_X1, sampling(telemetry.oversampling), filter(telemetry.filter));
+  }
+  return mActive;
+}
+
+// cppcheck-suppress unusedFunction
+void Sensor::sample() {
+  if (!mActive || !mBmp.takeForcedMeasurement()) {
+    return;
+  }
+  // readPressure() reads the temperature again for its compensation
+  mTemperatureSum += mBmp.readTemperature();
+  mPressureSum += mBmp.readPressure();
+  mCount++;
+}
+
+// cppcheck-suppress unusedFunction
+bool Sensor::due(unsigned long now_ms) const {
+  return mActive && mCount > 0 && (!mReported || now_ms - mReport_ms >= mConfig.rate * 1000UL);
+}
+
+// cppcheck-suppress unusedFunction
+void Sensor::appendReport(FrameBuilder &frame, time_t utc, float battery_volts) const {
+  float pressure    = mPressureSum / max(1U, (unsigned)mCount) / 100; // hPa
+  float temperature = mTemperatureSum / max(1U, (unsigned)mCount);
+  if (mConfig.format == Configuration::Telemetry::FormatTelemetry) {
+    frame.append("T#").appendNumber(mSequence % 1000, 3);
+    frame.append(',').appendNumber(analog(pressure, 900, PressureStep), 3);
+    frame.append(',').appendNumber(analog(temperature, -40, TemperatureStep), 3);
+    frame.append(',').appendNumber(analog(battery_volts, 0, BatteryStep), 3);
+    frame.append(",000,000,00000000");
+    return;
+  }
+  // positionless weather report, no wind known, temperature in F
+  long fahrenheit = max(-99L, min(999L, lround(temperature * 9 / 5 + 32)));
+  frame.append('_').appendNumber(month(utc), 2).appendNumber(day(utc), 2).appendNumber(hour(utc), 2).appendNumber(minute(utc), 2);
+  frame.append("c...s...g...t");
+  if (fahrenheit < 0) {
+    frame.append('-').appendNumber(-fahrenheit, 2);
+  } else {
+    frame.appendNumber(fahrenheit, 3);
+  }
+  frame.append('b').appendNumber(max(0L, min(99999L, lround(pressure * 10))), 5);
+}
+
+// cppcheck-suppress unusedFunction
+bool Sensor::definitionsDue() const {
+  return mConfig.format == Configuration::Telemetry::FormatTelemetry && mSequence % 16 == 0;
+}
+
+// cppcheck-suppress unusedFunction
+void Sensor::appendDefinition(FrameBuilder &frame, const String &callsign, int index) const {
+  frame.append(':').append(callsign);
+  for (size_t i = callsign.length(); i < 9; i++) {
+    frame.append(' ');
+  }
+  switch (index) {
+    case 0:
+      frame.append(":PARM.Pressure,Temp,Battery");
+      break;
+    case 1:
+      frame.append(":UNIT.hPa,deg.C,V");
+      break;
+    default:
+      frame.append(":EQNS.0,0.8,900,0,0.4,-40,0,0.02,0");
+      break;
+  }
+}
+
+// cppcheck-suppress unusedFunction
+void Sensor::sent(unsigned long now_ms) {
+  mCount          = 0;
+  mPressureSum    = 0;
+  mTemperatureSum = 0;
+  mReport_ms      = now_ms;
+  mReported       = true;
+  mSequence++;
+}
+
+// cppcheck-suppress unusedFunction
+void Sensor::retain(Retained &retained, unsigned long now_ms) const {
+  retained.count           = mCount;
+  retained.pressure_sum    = mPressureSum;
+  retained.temperature_sum = mTemperatureSum;
+  retained.report_age_ms   = now_ms - mReport_ms;
+  retained.sequence        = mSequence;
+  retained.reported        = mReported;
+}
+
+// cppcheck-suppress unusedFunction
+void Sensor::resume(const Retained &retained, uint32_t slept_ms) {
+  mCount          = retained.count;
+  mPressureSum    = retained.pressure_sum;
+  mTemperatureSum = retained.temperature_sum;
+  mReport_ms      = 0UL - (retained.report_age_ms + slept_ms);
+  mSequence       = retained.sequence;
+  mReported       = retained.reported;
+}
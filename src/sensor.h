@@ -2,12 +2,63 @@
 //for lora APRS BEACON
 //Xynium 03 2023
 
+#ifndef SENSOR_H_
+#define SENSOR_H_
+
 #include <Arduino.h>
-#include <Adafruit_Sensor.h>  // include Adafruit sensor library
+#include <Adafruit_Sensor.h>  // include adafruit sensor library
 #include <Adafruit_BMP280.h>  // include adafruit library for BMP280 sensor
 
+#include "configuration.h"
+#include "frame_builder.h"
+
 #define BMP280_I2C_ADDRESS  0x76
 
+// BMP280 read in forced mode: one measurement at each wake up, after which
+// the chip sleeps on its own at 0.1 uA, added to sums that the telemetry
+// frame sends as averages at its own, lower rate.
+class Sensor {
+public:
+  explicit Sensor(TwoWire &wire);
+
+  // False when there is no BMP280 or telemetry is off.
+  bool begin(const Configuration::Telemetry &telemetry);
+  void sample();
+  // A frame is due and there are samples to send.
+  bool due(unsigned long now_ms) const;
+  // The information field of the frame, weather or T# telemetry, with the
+  // battery voltage in the telemetry.
+  void appendReport(FrameBuilder &frame, time_t utc, float battery_volts) const;
+  // The PARM, UNIT and EQNS messages scaling the T# values, addressed to
+  // callsign: due with the first telemetry frame and every 16th.
+  bool definitionsDue() const;
+  void appendDefinition(FrameBuilder &frame, const String &callsign, int index) const;
+  void sent(unsigned long now_ms);
+
+  struct Retained {
+    uint32_t count;
+    float    pressure_sum;
+    float    temperature_sum;
+    uint32_t report_age_ms;
+    uint16_t sequence;
+    bool     reported;
+  };
+  void retain(Retained &retained, unsigned long now_ms) const;
+  void resume(const Retained &retained, uint32_t slept_ms);
+
+  static const int Definitions = 3;
 
+private:
+  Adafruit_BMP280                   mBmp;
+  Configuration::Telemetry          mConfig;
+  bool                              mActive;
+  uint32_t                          mCount;
+  float                             mPressureSum;    // Pa
+  float                             mTemperatureSum; // degrees C
+  unsigned long                     mReport_ms;
+  uint16_t                          mSequence;
+  bool                              mReported;
+};
 
-//END
\ No newline at end of file
+#endif
+//END
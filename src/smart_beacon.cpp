@@ -0,0 +1,86 @@
+#include "smart_beacon.h"
+
+SmartBeacon::SmartBeacon() : mTriggered(false), mSent(false), mLastBeacon_ms(0), mLastCourse(0), mSpeed_kmh(0) {
+}
+
+void SmartBeacon::begin(const Configuration::Beacon::Smart_Beacon &config) {
+  mConfig = config;
+}
+
+// cppcheck-suppress unusedFunction
+void SmartBeacon::trigger() {
+  mTriggered = true;
+}
+
+int SmartBeacon::headingChange(int from, int to) {
+  int change = abs(to - from) % 360;
+  return change > 180 ? 360 - change : change;
+}
+
+int SmartBeacon::rate_s(int speed_kmh) const {
+  if (speed_kmh <= mConfig.slow_speed) {
+    return mConfig.slow_rate;
+  }
+  if (speed_kmh >= mConfig.fast_speed) {
+    return mConfig.fast_rate;
+  }
+  return max(mConfig.fast_rate, min(mConfig.slow_rate, mConfig.fast_rate * mConfig.fast_speed / speed_kmh));
+}
+
+// cppcheck-suppress unusedFunction
+bool SmartBeacon::due(unsigned long now_ms, int speed_kmh, int course) {
+  mSpeed_kmh = speed_kmh;
+  if (mTriggered || !mSent) {
+    return true;
+  }
+  unsigned long elapsed_s = (now_ms - mLastBeacon_ms) / 1000;
+  if (elapsed_s >= (unsigned long)rate_s(speed_kmh)) {
+    return true;
+  }
+  if (speed_kmh > mConfig.slow_speed && elapsed_s >= (unsigned long)mConfig.turn_time) {
+    int threshold = mConfig.turn_min + mConfig.turn_slope / speed_kmh;
+    return headingChange(mLastCourse, course) > threshold;
+  }
+  return false;
+}
+
+// cppcheck-suppress unusedFunction
+void SmartBeacon::sent(unsigned long now_ms, int course) {
+  mTriggered     = false;
+  mSent          = true;
+  mLastBeacon_ms = now_ms;
+  mLastCourse    = course;
+}
+
+// Until the next beacon at the current speed, or until the next course check
+// when moving.
+// cppcheck-suppress unusedFunction
+uint32_t SmartBeacon::nextWake_s(unsigned long now_ms) const {
+  long remaining = rate_s(mSpeed_kmh) - (long)((now_ms - mLastBeacon_ms) / 1000);
+  if (moving()) {
+    remaining = min(remaining, (long)mConfig.turn_time);
+  }
+  return max(1L, remaining);
+}
+
+bool SmartBeacon::moving() const {
+  return mSpeed_kmh > mConfig.slow_speed;
+}
+
+// cppcheck-suppress unusedFunction
+void SmartBeacon::retain(Retained &retained, unsigned long now_ms) const {
+  retained.triggered     = mTriggered;
+  retained.sent          = mSent;
+  retained.beacon_age_ms = now_ms - mLastBeacon_ms;
+  retained.last_course   = mLastCourse;
+  retained.speed_kmh     = mSpeed_kmh;
+}
+
+// cppcheck-suppress unusedFunction
+void SmartBeacon::resume(const Retained &retained, uint32_t slept_ms) {
+  mTriggered     = retained.triggered;
+  mSent          = retained.sent;
+  mLastBeacon_ms = 0UL - (retained.beacon_age_ms + slept_ms);
+  mLastCourse    = retained.last_course;
+  mSpeed_kmh     = retained.speed_kmh;
+}
@@ -0,0 +1,48 @@
+#ifndef SMART_BEACON_H_
+#define SMART_BEACON_H_
+
+#include <Arduino.h>
+
+#include "configuration.h"
+
+// SmartBeaconing: the beacon rate follows the speed between slow_rate and
+// fast_rate, and a change of course larger than turn_min + turn_slope / speed
+// triggers a beacon early (corner pegging), at most every turn_time.
+class SmartBeacon {
+public:
+  SmartBeacon();
+
+  void begin(const Configuration::Beacon::Smart_Beacon &config);
+  void trigger();
+
+  // With a fresh fix, true when a beacon has to be sent now.
+  bool     due(unsigned long now_ms, int speed_kmh, int course);
+  void     sent(unsigned long now_ms, int course);
+  int      rate_s(int speed_kmh) const;
+  uint32_t nextWake_s(unsigned long now_ms) const;
+  bool     moving() const;
+
+  // State kept in RTC memory over a deep sleep. millis() starts again from 0
+  // after the wake up, so the time of the last beacon is kept as its age.
+  struct Retained {
+    bool     triggered;
+    bool     sent;
+    uint32_t beacon_age_ms;
+    int      last_course;
+    int      speed_kmh;
+  };
+  void retain(Retained &retained, unsigned long now_ms) const;
+  void resume(const Retained &retained, uint32_t slept_ms);
+
+private:
+  static int headingChange(int from, int to);
+
+  Configuration::Beacon::Smart_Beacon mConfig;
+  bool                                mTriggered;
+  bool                                mSent;
+  unsigned long                       mLastBeacon_ms;
+  int                                 mLastCourse;
+  int                                 mSpeed_kmh;
+};
+
+#endif
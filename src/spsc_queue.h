@@ -0,0 +1,44 @@
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <atomic>
+#include <stddef.h>
+
+// Lock-free ring between one producer and one consumer, which may run on
+// different cores. Holds Size - 1 items: push() fails when it is full and
+// leaves the queue as it is.
+template <typename T, size_t Size> class SpscQueue {
+public:
+  SpscQueue() : mHead(0), mTail(0) {
+  }
+
+  // Producer side.
+  bool push(const T &item) {
+    size_t head = mHead.load(std::memory_order_relaxed);
+    size_t next = (head + 1) % Size;
+    if (next == mTail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    mItems[head] = item;
+    mHead.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side.
+  bool pop(T &item) {
+    size_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail == mHead.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = mItems[tail];
+    mTail.store((tail + 1) % Size, std::memory_order_release);
+    return true;
+  }
+
+private:
+  T                   mItems[Size];
+  std::atomic<size_t> mHead; // next slot the producer writes
+  std::atomic<size_t> mTail; // next slot the consumer reads
+};
+
+#endif
@@ -0,0 +1,215 @@
+#include <SPIFFS.h>
+
+#include "config_image.h"
+#include "track_log.h"
+
+static const uint32_t TrackMagic   = 0x314B5254; // "TRK1"
+static const int      RecoverPages = 4;          // looked back for the sequence
+
+static_assert(sizeof(TrackLog::Page) == TrackLog::PageSize, "TrackLog::Page layout changed, see tools/track_export.py");
+
+TrackLog::TrackLog(const char *path, const char *old_path) : mPath(path), mOldPath(old_path), mRecovered(false), mSequence(0), mWritten(0), mUtc(0), mLat(0), mLng(0), mAltitude(0) {
+  memset(&mPage, 0, sizeof(mPage));
+}
+
+// cppcheck-suppress unusedFunction
+void TrackLog::begin(const Configuration::Track &config) {
+  mConfig = config;
+}
+
+void TrackLog::seal(Page &page, uint32_t sequence) const {
+  page.sequence = sequence;
+  page.crc      = config_crc32(0, &page, offsetof(Page, crc));
+}
+
+// Once per boot before the first write: the sequence goes on from the last
+// whole page, and a page cut short by a power loss is padded to the page
+// boundary so that the next one starts on it.
+bool TrackLog::recover() {
+  if (!ConfigurationManagement::mount()) {
+    return false;
+  }
+  if (mRecovered) {
+    return true;
+  }
+  mRecovered                = true;
+  const char *const paths[] = {mPath, mOldPath};
+  size_t            tail    = 0;
+  bool              found   = false;
+  for (int i = 0; i < 2 && !found; i++) {
+    File file = SPIFFS.open(paths[i], FILE_READ);
+    if (!file) {
+      continue;
+    }
+    size_t size = file.size();
+    if (i == 0) {
+      tail = size % PageSize;
+    }
+    Page page;
+    for (size_t at = size - size % PageSize; at >= PageSize && at + RecoverPages * PageSize > size && !found; at -= PageSize) {
+      if (file.seek(at - PageSize) && file.read((uint8_t *)&page, PageSize) == PageSize && page.magic == TrackMagic && page.crc == config_crc32(0, &page, offsetof(Page, crc))) {
+        mSequence = page.sequence + 1;
+        found     = true;
+      }
+    }
+    file.close();
+  }
+  if (tail) {
+    static const uint8_t zeros[PageSize] = {0};
+    File                 file            = SPIFFS.open(mPath, FILE_APPEND);
+    if (file) {
+      file.write(zeros, PageSize - tail);
+      file.close();
+    }
+  }
+  return true;
+}
+
+// Appends the page, the file becomes the old one once it holds half of
+// max_kb.
+void TrackLog::flush() {
+  if (!mPage.magic || !recover()) {
+    return;
+  }
+  File file = SPIFFS.open(mPath, FILE_READ);
+  if (file) {
+    size_t size = file.size();
+    file.close();
+    if (size + PageSize > (size_t)max(1, mConfig.max_kb) * 512) {
+      SPIFFS.remove(mOldPath);
+      SPIFFS.rename(mPath, mOldPath);
+    }
+  }
+  seal(mPage, mSequence);
+  file = SPIFFS.open(mPath, FILE_APPEND);
+  if (file) {
+    if (file.write((const uint8_t *)&mPage, PageSize) == PageSize) {
+      mSequence++;
+      mWritten++;
+    }
+    file.close();
+  }
+  memset(&mPage, 0, sizeof(mPage));
+}
+
+// cppcheck-suppress unusedFunction
+void TrackLog::add(time_t utc, double lat_deg, double lng_deg, double altitude_m, double speed_kmph) {
+  if (!mConfig.active) {
+    return;
+  }
+  int32_t lat      = lround(lat_deg * 1e5);
+  int32_t lng      = lround(lng_deg * 1e5);
+  int16_t altitude = max(-32768L, min(32767L, lround(altitude_m)));
+  uint8_t speed    = max(0L, min(255L, lround(speed_kmph)));
+  if (mPage.magic) {
+    if ((uint32_t)utc <= mUtc) {
+      return;
+    }
+    uint32_t dt = utc - mUtc;
+    if (dt <= 0xFFFF && abs(lat - mLat) <= 0x7FFF && abs(lng - mLng) <= 0x7FFF && abs(altitude - mAltitude) <= 0x7F) {
+      Record &record  = mPage.records[mPage.count++];
+      record.dt       = dt;
+      record.lat      = lat - mLat;
+      record.lng      = lng - mLng;
+      record.altitude = altitude - mAltitude;
+      record.speed    = speed;
+      mUtc            = utc;
+      mLat            = lat;
+      mLng            = lng;
+      mAltitude       = altitude;
+      if (mPage.count == Records) {
+        flush();
+      }
+      return;
+    }
+    // too far from the last fix for a record
+    flush();
+  }
+  mPage.magic    = TrackMagic;
+  mPage.utc      = utc;
+  mPage.lat      = lat;
+  mPage.lng      = lng;
+  mPage.altitude = altitude;
+  mPage.speed    = speed;
+  mPage.count    = 0;
+  mUtc           = utc;
+  mLat           = lat;
+  mLng           = lng;
+  mAltitude      = altitude;
+}
+
+// cppcheck-suppress unusedFunction
+size_t TrackLog::exportSize() {
+  size_t size = mPage.magic ? PageSize : 0;
+  if (!recover()) {
+    return size;
+  }
+  const char *const paths[] = {mOldPath, mPath};
+  for (int i = 0; i < 2; i++) {
+    File file = SPIFFS.open(paths[i], FILE_READ);
+    if (file) {
+      size += file.size();
+      file.close();
+    }
+  }
+  return size;
+}
+
+// cppcheck-suppress unusedFunction
+size_t TrackLog::exportTo(Print &out) {
+  size_t sent = 0;
+  if (recover()) {
+    const char *const paths[] = {mOldPath, mPath};
+    uint8_t           buffer[PageSize];
+    for (int i = 0; i < 2; i++) {
+      File file = SPIFFS.open(paths[i], FILE_READ);
+      if (!file) {
+        continue;
+      }
+      size_t length;
+      while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+        sent += out.write(buffer, length);
+      }
+      file.close();
+    }
+  }
+  if (mPage.magic) {
+    // sealed with the sequence it gets once written
+    Page page = mPage;
+    seal(page, mSequence);
+    sent += out.write((const uint8_t *)&page, PageSize);
+  }
+  return sent;
+}
+
+// cppcheck-suppress unusedFunction
+void TrackLog::print(Print &out) const {
+  if (!mConfig.active) {
+    return;
+  }
+  out.printf("Track      %u pages written, %u fixes waiting\n", (unsigned)mWritten, mPage.magic ? mPage.count + 1U : 0U);
+}
+
+// cppcheck-suppress unusedFunction
+void TrackLog::retain(Retained &retained) const {
+  retained.page      = mPage;
+  retained.recovered = mRecovered;
+  retained.sequence  = mSequence;
+  retained.written   = mWritten;
+  retained.utc       = mUtc;
+  retained.lat       = mLat;
+  retained.lng       = mLng;
+  retained.altitude  = mAltitude;
+}
+
+// cppcheck-suppress unusedFunction
+void TrackLog::resume(const Retained &retained) {
+  mPage      = retained.page;
+  mRecovered = retained.recovered;
+  mSequence  = retained.sequence;
+  mWritten   = retained.written;
+  mUtc       = retained.utc;
+  mLat       = retained.lat;
+  mLng       = retained.lng;
+  mAltitude  = retained.altitude;
+}
@@ -0,0 +1,87 @@
+#ifndef TRACK_LOG_H_
+#define TRACK_LOG_H_
+
+#include <Arduino.h>
+
+#include "configuration.h"
+
+// Every fix kept in a SPIFFS file for the whole trip, whether a digipeater
+// heard the beacon or not. The fixes are packed in 256 byte pages that are
+// only appended once full, so the file grows once per 29 fixes: a page starts
+// with a full fix and holds the next ones as changes from the fix before, and
+// ends with a CRC-32. The file is never rewritten, though SPIFFS still adds
+// its page headers and updates its index at each append. A page cut short by a power loss
+// fails its CRC and the next one starts on the following boundary. Past half
+// of max_kb the file becomes the old one, replacing the previous old one.
+// tools/track_export.py reads the pages back.
+class TrackLog {
+public:
+  TrackLog(const char *path, const char *old_path);
+
+  void begin(const Configuration::Track &config);
+  void add(time_t utc, double lat_deg, double lng_deg, double altitude_m, double speed_kmph);
+
+  // The old file, the file, then the page being filled.
+  size_t exportSize();
+  size_t exportTo(Print &out);
+  void   print(Print &out) const;
+
+  static const size_t PageSize = 256;
+  static const int    Records  = 28;
+
+  struct Record {
+    uint16_t dt; // s
+    int16_t  lat; // 1e-5 degree
+    int16_t  lng;
+    int8_t   altitude; // m
+    uint8_t  speed; // km/h
+  };
+
+  struct Page {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t utc;
+    int32_t  lat; // 1e-5 degree
+    int32_t  lng;
+    int16_t  altitude; // m
+    uint8_t  speed; // km/h
+    uint8_t  count; // records
+    Record   records[Records];
+    uint32_t reserved;
+    uint32_t crc;
+  };
+
+  // The page being filled kept over a deep sleep.
+  struct Retained {
+    Page     page;
+    bool     recovered;
+    uint32_t sequence;
+    uint32_t written;
+    uint32_t utc;
+    int32_t  lat;
+    int32_t  lng;
+    int16_t  altitude;
+  };
+  void retain(Retained &retained) const;
+  void resume(const Retained &retained);
+
+private:
+  bool recover();
+  void flush();
+  void seal(Page &page, uint32_t sequence) const;
+
+  const char              *mPath;
+  const char              *mOldPath;
+  Configuration::Track     mConfig;
+  Page                     mPage;
+  bool                     mRecovered;
+  uint32_t                 mSequence;
+  uint32_t                 mWritten; // pages
+  // last fix of the page, the records are changes from it
+  uint32_t                 mUtc;
+  int32_t                  mLat;
+  int32_t                  mLng;
+  int16_t                  mAltitude;
+};
+
+#endif
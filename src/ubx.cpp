@@ -0,0 +1,186 @@
+#include "ubx.h"
+
+static void put_u16(uint8_t *p, uint16_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t value) {
+  put_u16(p, value);
+  put_u16(p + 2, value >> 16);
+}
+
+// cppcheck-suppress unusedFunction
+size_t ubx_build(uint8_t *buffer, size_t size, uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t length) {
+  size_t total = length + 8;
+  if (total > size) {
+    return 0;
+  }
+  buffer[0] = UBX_SYNC1;
+  buffer[1] = UBX_SYNC2;
+  buffer[2] = msg_class;
+  buffer[3] = msg_id;
+  put_u16(buffer + 4, length);
+  if (length) {
+    memcpy(buffer + 6, payload, length);
+  }
+  // 8-bit Fletcher over class, id, length and payload
+  uint8_t ck_a = 0;
+  uint8_t ck_b = 0;
+  for (size_t i = 2; i < total - 2; i++) {
+    ck_a += buffer[i];
+    ck_b += ck_a;
+  }
+  buffer[total - 2] = ck_a;
+  buffer[total - 1] = ck_b;
+  return total;
+}
+
+UbxParser::UbxParser() : mState(WaitSync1), mClass(0), mId(0), mLength(0), mIndex(0), mCkA(0), mCkB(0) {
+}
+
+bool UbxParser::feed(uint8_t c) {
+  if (mState >= ReadClass && mState <= ReadPayload) {
+    mCkA += c;
+    mCkB += mCkA;
+  }
+  switch (mState) {
+    case WaitSync1:
+      if (c == UBX_SYNC1) {
+        mState = WaitSync2;
+      }
+      break;
+    case WaitSync2:
+      mState = c == UBX_SYNC2 ? ReadClass : (c == UBX_SYNC1 ? WaitSync2 : WaitSync1);
+      mCkA   = 0;
+      mCkB   = 0;
+      break;
+    case ReadClass:
+      mClass = c;
+      mState = ReadId;
+      break;
+    case ReadId:
+      mId    = c;
+      mState = ReadLength1;
+      break;
+    case ReadLength1:
+      mLength = c;
+      mState  = ReadLength2;
+      break;
+    case ReadLength2:
+      mLength |= c << 8;
+      mIndex = 0;
+      if (mLength > UBX_MAX_PAYLOAD) {
+        mState = WaitSync1;
+      } else {
+        mState = mLength ? ReadPayload : ReadCkA;
+      }
+      break;
+    case ReadPayload:
+      mPayload[mIndex++] = c;
+      if (mIndex == mLength) {
+        mState = ReadCkA;
+      }
+      break;
+    case ReadCkA:
+      mState = c == mCkA ? ReadCkB : WaitSync1;
+      break;
+    case ReadCkB:
+      mState = WaitSync1;
+      return c == mCkB;
+  }
+  return false;
+}
+
+UbxGps::UbxGps(Stream &port) : mPort(port) {
+}
+
+void UbxGps::send(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t length) {
+  uint8_t frame[UBX_MAX_PAYLOAD + 8];
+  size_t  size = ubx_build(frame, sizeof(frame), msg_class, msg_id, payload, length);
+  mPort.write(frame, size);
+}
+
+// NMEA received while waiting for the acknowledge is dropped.
+bool UbxGps::sendWithAck(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t length, uint32_t timeout_ms) {
+  send(msg_class, msg_id, payload, length);
+  unsigned long start = millis();
+  while (millis() - start < timeout_ms) {
+    while (mPort.available() > 0) {
+      if (mParser.feed(mPort.read()) && mParser.msgClass() == UBX_CLASS_ACK && mParser.length() == 2 && mParser.payload()[0] == msg_class && mParser.payload()[1] == msg_id) {
+        return mParser.msgId() == UBX_ACK_ACK;
+      }
+    }
+    delay(1);
+  }
+  return false;
+}
+
+// cppcheck-suppress unusedFunction
+bool UbxGps::receive(uint8_t msg_class, uint8_t msg_id, uint32_t timeout_ms) {
+  unsigned long start = millis();
+  while (millis() - start < timeout_ms) {
+    while (mPort.available() > 0) {
+      if (mParser.feed(mPort.read()) && mParser.msgClass() == msg_class && mParser.msgId() == msg_id) {
+        return true;
+      }
+    }
+    delay(1);
+  }
+  return false;
+}
+
+// cppcheck-suppress unusedFunction
+void UbxGps::setBaudRate(uint32_t baud) {
+  uint8_t prt[20];
+  memset(prt, 0, sizeof(prt));
+  prt[0] = 0x01;                // UART1
+  put_u32(prt + 4, 0x000008D0); // 8N1
+  put_u32(prt + 8, baud);
+  put_u16(prt + 12, 0x0003);    // in UBX + NMEA
+  put_u16(prt + 14, 0x0003);    // out UBX + NMEA
+  send(UBX_CLASS_CFG, UBX_CFG_PRT, prt, sizeof(prt));
+  mPort.flush();
+}
+
+// cppcheck-suppress unusedFunction
+bool UbxGps::setNmeaRate(uint8_t nmea_id, uint8_t rate) {
+  const uint8_t msg[3] = {UBX_CLASS_NMEA, nmea_id, rate};
+  return sendWithAck(UBX_CLASS_CFG, UBX_CFG_MSG, msg, sizeof(msg));
+}
+
+// cppcheck-suppress unusedFunction
+bool UbxGps::setContinuous() {
+  const uint8_t rxm[2] = {0x08, 0x00};
+  return sendWithAck(UBX_CLASS_CFG, UBX_CFG_RXM, rxm, sizeof(rxm));
+}
+
+// cppcheck-suppress unusedFunction
+bool UbxGps::setCyclic(uint32_t update_period_ms) {
+  uint8_t pm2[44];
+  memset(pm2, 0, sizeof(pm2));
+  pm2[0] = 0x01;                         // version
+  put_u32(pm2 + 4, 0x00021800);          // cyclic tracking, update RTC and ephemeris
+  put_u32(pm2 + 8, update_period_ms);    // updatePeriod
+  put_u32(pm2 + 12, 2 * update_period_ms); // searchPeriod
+  put_u16(pm2 + 20, 2);                  // onTime s
+  if (!sendWithAck(UBX_CLASS_CFG, UBX_CFG_PM2, pm2, sizeof(pm2))) {
+    return false;
+  }
+  const uint8_t rxm[2] = {0x08, 0x01};
+  return sendWithAck(UBX_CLASS_CFG, UBX_CFG_RXM, rxm, sizeof(rxm));
+}
+
+// cppcheck-suppress unusedFunction
+void UbxGps::backup(uint32_t duration_ms) {
+  uint8_t pmreq[8];
+  put_u32(pmreq, duration_ms);
+  put_u32(pmreq + 4, 0x00000002); // backup
+  send(UBX_CLASS_RXM, UBX_RXM_PMREQ, pmreq, sizeof(pmreq));
+}
+
+// cppcheck-suppress unusedFunction
+void UbxGps::wake() {
+  const uint8_t wakeup[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  mPort.write(wakeup, sizeof(wakeup));
+}
@@ -0,0 +1,120 @@
+#ifndef UBX_H_
+#define UBX_H_
+
+#include <Arduino.h>
+
+#define UBX_SYNC1 0xB5
+#define UBX_SYNC2 0x62
+
+#define UBX_CLASS_RXM  0x02
+#define UBX_CLASS_ACK  0x05
+#define UBX_CLASS_CFG  0x06
+#define UBX_CLASS_AID  0x0B
+#define UBX_CLASS_NMEA 0xF0
+
+#define UBX_ACK_NAK   0x00
+#define UBX_ACK_ACK   0x01
+#define UBX_CFG_PRT   0x00
+#define UBX_CFG_MSG   0x01
+#define UBX_CFG_RXM   0x11
+#define UBX_CFG_PM2   0x3B
+#define UBX_RXM_PMREQ 0x41
+#define UBX_AID_INI   0x01
+#define UBX_AID_EPH   0x31
+
+// ids of the standard NMEA sentences in the UBX_CLASS_NMEA class
+#define UBX_NMEA_GGA 0x00
+#define UBX_NMEA_GLL 0x01
+#define UBX_NMEA_GSA 0x02
+#define UBX_NMEA_GSV 0x03
+#define UBX_NMEA_RMC 0x04
+#define UBX_NMEA_VTG 0x05
+
+#define UBX_MAX_PAYLOAD 256
+
+// Writes a UBX frame (sync, class, id, length, payload, checksum) into buffer.
+// Returns the frame length, 0 when it does not fit.
+size_t ubx_build(uint8_t *buffer, size_t size, uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t length);
+
+// Picks the UBX frames out of the receiver output byte by byte, skipping the
+// NMEA sentences in between.
+class UbxParser {
+public:
+  UbxParser();
+
+  // true when c completes a frame with a valid checksum
+  bool feed(uint8_t c);
+
+  uint8_t msgClass() const {
+    return mClass;
+  }
+  uint8_t msgId() const {
+    return mId;
+  }
+  uint16_t length() const {
+    return mLength;
+  }
+  const uint8_t *payload() const {
+    return mPayload;
+  }
+
+private:
+  enum State {
+    WaitSync1,
+    WaitSync2,
+    ReadClass,
+    ReadId,
+    ReadLength1,
+    ReadLength2,
+    ReadPayload,
+    ReadCkA,
+    ReadCkB
+  };
+
+  State    mState;
+  uint8_t  mClass;
+  uint8_t  mId;
+  uint16_t mLength;
+  uint16_t mIndex;
+  uint8_t  mCkA;
+  uint8_t  mCkB;
+  uint8_t  mPayload[UBX_MAX_PAYLOAD];
+};
+
+// u-blox NEO-6M / NEO-M8N power modes over UBX.
+class UbxGps {
+public:
+  explicit UbxGps(Stream &port);
+
+  void send(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t length);
+  bool sendWithAck(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t length, uint32_t timeout_ms = 1000);
+  // Waits for the next frame of that class and id, left in parser().
+  bool receive(uint8_t msg_class, uint8_t msg_id, uint32_t timeout_ms = 1000);
+
+  // Switches the receiver's UART to baud, 8N1, UBX and NMEA. The answer
+  // comes at the new rate so it is not waited for.
+  void setBaudRate(uint32_t baud);
+  // Output rate of an NMEA sentence on the receiver's UART, 0 turns it off.
+  bool setNmeaRate(uint8_t nmea_id, uint8_t rate);
+
+  // Full power tracking (CFG-RXM max performance).
+  bool setContinuous();
+  // Power save mode, the receiver wakes for a fix every update_period_ms and
+  // keeps its ephemeris up to date on its own (CFG-PM2 + CFG-RXM).
+  bool setCyclic(uint32_t update_period_ms);
+  // Software backup for duration_ms (RXM-PMREQ), RAM and RTC are kept so the
+  // next start is a hot start. The receiver does not acknowledge it.
+  void backup(uint32_t duration_ms);
+  // Any activity on the receiver's RX line ends the backup early.
+  void wake();
+
+  UbxParser &parser() {
+    return mParser;
+  }
+
+private:
+  Stream   &mPort;
+  UbxParser mParser;
+};
+
+#endif
@@ -0,0 +1,74 @@
+// Geofence::lookup() against tools/geofence_image.py on the file and points
+// it writes with --fixture test/test_geofence, src/bench/bench.cpp times it:
+// pio test -e native -f test_geofence
+#include <SPIFFS.h>
+#include <unity.h>
+
+#include <stdio.h>
+#include <vector>
+
+#include "geofence.h"
+
+static const char FixturePath[]  = "test/test_geofence/";
+static const char GeofencePath[] = "/test_geofence.bin";
+
+struct Point {
+  int32_t lat;
+  int32_t lng;
+  int16_t zone;
+} __attribute__((packed));
+
+static std::vector<uint8_t> read_fixture(const char *name) {
+  std::vector<uint8_t> data;
+  String               path = String(FixturePath) + name;
+  FILE                *f    = fopen(path.c_str(), "rb");
+  if (f) {
+    uint8_t buffer[4096];
+    size_t  length;
+    while ((length = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+      data.insert(data.end(), buffer, buffer + length);
+    }
+    fclose(f);
+  }
+  return data;
+}
+
+static std::vector<Point> points;
+
+void setUp() {
+  std::vector<uint8_t> image = read_fixture("geofence.bin");
+  TEST_ASSERT_GREATER_THAN(0, image.size());
+  TEST_ASSERT_TRUE(SPIFFS.begin());
+  File file = SPIFFS.open(GeofencePath, FILE_WRITE);
+  TEST_ASSERT_EQUAL(image.size(), file.write(image.data(), image.size()));
+  file.close();
+  std::vector<uint8_t> data = read_fixture("points.bin");
+  points.assign((const Point *)data.data(), (const Point *)(data.data() + data.size()));
+  TEST_ASSERT_GREATER_THAN(0, points.size());
+}
+
+void tearDown() {
+  SPIFFS.remove(GeofencePath);
+}
+
+void test_lookup_matches_the_tool() {
+  Geofence geofence(GeofencePath);
+  geofence.begin(Configuration());
+  int mismatches = 0;
+  int inside     = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    int zone = geofence.lookup(points[i].lat, points[i].lng);
+    if (zone != points[i].zone && mismatches++ < 5) {
+      printf("%d %d: zone %d, the tool finds %d\n", points[i].lat, points[i].lng, zone, points[i].zone);
+    }
+    inside += zone >= 0;
+  }
+  TEST_ASSERT_EQUAL(0, mismatches);
+  TEST_ASSERT_GREATER_THAN(100, inside);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_lookup_matches_the_tool);
+  return UNITY_END();
+}
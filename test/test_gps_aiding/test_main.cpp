@@ -0,0 +1,194 @@
+// UBX framing and the ephemeris file of GpsAiding, against fixed frames:
+// pio test -e native
+#include <SPIFFS.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "gps_aiding.h"
+#include "ubx.h"
+
+// The receiver side of the UART: what it sends is queued beforehand, what
+// the firmware writes is kept.
+class FakePort : public Stream {
+public:
+  FakePort() : mRead(0) {
+  }
+  void queue(const uint8_t *data, size_t length) {
+    mInput.insert(mInput.end(), data, data + length);
+  }
+  int available() override {
+    return mInput.size() - mRead;
+  }
+  int read() override {
+    return mRead < mInput.size() ? mInput[mRead++] : -1;
+  }
+  size_t write(uint8_t c) override {
+    output.push_back(c);
+    return 1;
+  }
+  using Print::write;
+
+  std::vector<uint8_t> output;
+
+private:
+  std::vector<uint8_t> mInput;
+  size_t               mRead;
+};
+
+static const char AidingPath[] = "/test_aiding.bin";
+
+// CFG-MSG turning GLL off, as in the u-blox protocol specification.
+static const uint8_t CfgMsgGllOff[] = {0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x01, 0x00, 0xFB, 0x11};
+
+// AID-EPH of SV 5 (SVID, HOW, 96 bytes of subframes 1 to 3), and of SV 7
+// without an ephemeris.
+static uint8_t       Ephemeris[104];
+static const uint8_t EphemerisCk[2] = {0x97, 0xE6};
+static const uint8_t NoEphemeris[]  = {0xB5, 0x62, 0x0B, 0x31, 0x08, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4B, 0x27};
+
+static void fill_ephemeris() {
+  static const uint8_t header[8] = {0x05, 0x00, 0x00, 0x00, 0xCD, 0xAB, 0x34, 0x12};
+  memcpy(Ephemeris, header, sizeof(header));
+  for (int i = 0; i < 96; i++) {
+    Ephemeris[8 + i] = i * 37 + 11;
+  }
+}
+
+// The frames in data, fed to a parser as the firmware reads them.
+static std::vector<std::vector<uint8_t> > frames(const std::vector<uint8_t> &data, uint8_t msg_class, uint8_t msg_id) {
+  std::vector<std::vector<uint8_t> > found;
+  UbxParser                          parser;
+  for (size_t i = 0; i < data.size(); i++) {
+    if (parser.feed(data[i]) && parser.msgClass() == msg_class && parser.msgId() == msg_id) {
+      found.push_back(std::vector<uint8_t>(parser.payload(), parser.payload() + parser.length()));
+    }
+  }
+  return found;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+void setUp() {
+  fill_ephemeris();
+}
+
+void tearDown() {
+  SPIFFS.remove(AidingPath);
+}
+
+void test_build_matches_specification() {
+  uint8_t       frame[16];
+  const uint8_t payload[] = {0xF0, 0x01, 0x00};
+  TEST_ASSERT_EQUAL(sizeof(CfgMsgGllOff), ubx_build(frame, sizeof(frame), UBX_CLASS_CFG, UBX_CFG_MSG, payload, sizeof(payload)));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(CfgMsgGllOff, frame, sizeof(CfgMsgGllOff));
+  TEST_ASSERT_EQUAL(0, ubx_build(frame, 10, UBX_CLASS_CFG, UBX_CFG_MSG, payload, sizeof(payload)));
+
+  uint8_t eph[112];
+  TEST_ASSERT_EQUAL(sizeof(eph), ubx_build(eph, sizeof(eph), UBX_CLASS_AID, UBX_AID_EPH, Ephemeris, sizeof(Ephemeris)));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(EphemerisCk, eph + 110, 2);
+}
+
+void test_parser_skips_nmea_and_bad_checksums() {
+  const char           nmea[] = "$GPGGA,083000.00,4545.58320,N,00450.48370,E,1,08,1.02,172.4,M,47.3,M,,*6B\r\n";
+  std::vector<uint8_t> data(nmea, nmea + sizeof(nmea) - 1);
+  uint8_t              eph[112];
+  ubx_build(eph, sizeof(eph), UBX_CLASS_AID, UBX_AID_EPH, Ephemeris, sizeof(Ephemeris));
+  data.insert(data.end(), eph, eph + sizeof(eph));
+  // the same frame with a byte of the payload changed
+  eph[40] ^= 0x10;
+  data.insert(data.end(), eph, eph + sizeof(eph));
+  data.insert(data.end(), NoEphemeris, NoEphemeris + sizeof(NoEphemeris));
+
+  std::vector<std::vector<uint8_t> > found = frames(data, UBX_CLASS_AID, UBX_AID_EPH);
+  TEST_ASSERT_EQUAL(2, found.size());
+  TEST_ASSERT_EQUAL(sizeof(Ephemeris), found[0].size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(Ephemeris, found[0].data(), sizeof(Ephemeris));
+  TEST_ASSERT_EQUAL(8, found[1].size());
+}
+
+// Saves what the receiver answers to the poll, as after a beacon.
+static void save(time_t utc) {
+  FakePort port;
+  UbxGps   ubx(port);
+  uint8_t  eph[112];
+  ubx_build(eph, sizeof(eph), UBX_CLASS_AID, UBX_AID_EPH, Ephemeris, sizeof(Ephemeris));
+  port.queue(eph, sizeof(eph));
+  port.queue(NoEphemeris, sizeof(NoEphemeris));
+  GpsAiding saving(ubx, AidingPath);
+  saving.setPosition(457597200, 48413900, 17240);
+  TEST_ASSERT_EQUAL(1, saving.save(millis(), utc));
+  TEST_ASSERT_EQUAL(1, frames(port.output, UBX_CLASS_AID, UBX_AID_EPH).size());
+}
+
+void test_round_trip_through_the_file() {
+  const time_t saved = 1792000000;
+  save(saved);
+  FakePort  port;
+  UbxGps    ubx(port);
+  GpsAiding aiding(ubx, AidingPath);
+
+  TEST_ASSERT_EQUAL(1, aiding.restore(saved + 3600));
+  std::vector<std::vector<uint8_t> > ini = frames(port.output, UBX_CLASS_AID, UBX_AID_INI);
+  TEST_ASSERT_EQUAL(1, ini.size());
+  TEST_ASSERT_EQUAL(48, ini[0].size());
+  TEST_ASSERT_EQUAL(457597200, (int32_t)get_u32(&ini[0][0]));
+  TEST_ASSERT_EQUAL(48413900, (int32_t)get_u32(&ini[0][4]));
+  TEST_ASSERT_EQUAL(17240, (int32_t)get_u32(&ini[0][8]));
+  // position, lla and time
+  TEST_ASSERT_EQUAL(0x23, get_u32(&ini[0][44]));
+  std::vector<std::vector<uint8_t> > eph = frames(port.output, UBX_CLASS_AID, UBX_AID_EPH);
+  TEST_ASSERT_EQUAL(1, eph.size());
+  TEST_ASSERT_EQUAL(sizeof(Ephemeris), eph[0].size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(Ephemeris, eph[0].data(), sizeof(Ephemeris));
+}
+
+void test_stale_ephemerides_are_not_restored() {
+  const time_t saved = 1792000000;
+  save(saved);
+  FakePort  port;
+  UbxGps    ubx(port);
+  GpsAiding aiding(ubx, AidingPath);
+
+  TEST_ASSERT_EQUAL(0, aiding.restore(saved + GpsAiding::EphemerisValidity_s + 60));
+  // the position still goes
+  TEST_ASSERT_EQUAL(1, frames(port.output, UBX_CLASS_AID, UBX_AID_INI).size());
+  TEST_ASSERT_EQUAL(0, frames(port.output, UBX_CLASS_AID, UBX_AID_EPH).size());
+  // nor when their age is unknown
+  TEST_ASSERT_EQUAL(0, aiding.restore(0));
+  TEST_ASSERT_EQUAL(0, frames(port.output, UBX_CLASS_AID, UBX_AID_EPH).size());
+  TEST_ASSERT_EQUAL(0, aiding.replay(saved + GpsAiding::EphemerisValidity_s + 60));
+  TEST_ASSERT_EQUAL(0, frames(port.output, UBX_CLASS_AID, UBX_AID_EPH).size());
+}
+
+// After a reboot the time comes later from the receiver.
+void test_replay_once_the_time_is_known() {
+  const time_t saved = 1792000000;
+  save(saved);
+  FakePort  port;
+  UbxGps    ubx(port);
+  GpsAiding aiding(ubx, AidingPath);
+
+  TEST_ASSERT_EQUAL(0, aiding.restore(0));
+  TEST_ASSERT_TRUE(aiding.pending());
+  TEST_ASSERT_EQUAL(0, frames(port.output, UBX_CLASS_AID, UBX_AID_EPH).size());
+  TEST_ASSERT_EQUAL(1, aiding.replay(saved + 3600));
+  TEST_ASSERT_FALSE(aiding.pending());
+  std::vector<std::vector<uint8_t> > eph = frames(port.output, UBX_CLASS_AID, UBX_AID_EPH);
+  TEST_ASSERT_EQUAL(1, eph.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(Ephemeris, eph[0].data(), sizeof(Ephemeris));
+  // only once
+  TEST_ASSERT_EQUAL(0, aiding.replay(saved + 3660));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_build_matches_specification);
+  RUN_TEST(test_parser_skips_nmea_and_bad_checksums);
+  RUN_TEST(test_round_trip_through_the_file);
+  RUN_TEST(test_stale_ephemerides_are_not_restored);
+  RUN_TEST(test_replay_once_the_time_is_known);
+  return UNITY_END();
+}
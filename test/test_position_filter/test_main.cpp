@@ -0,0 +1,95 @@
+// PositionFilter on made-up bursts: pio test -e native -f test_position_filter
+#include <unity.h>
+
+#include "position_filter.h"
+
+static Configuration::Beacon beacon;
+static PositionFilter        filter;
+static unsigned long         epoch_ms;
+
+// A fresh burst one second after the previous one, still at speed 0.
+static GpsFix burst(double lat_deg, double lng_deg, double hdop) {
+  GpsFix fix;
+  memset(&fix, 0, sizeof(fix));
+  epoch_ms += 1000;
+  fix.epoch_ms       = epoch_ms;
+  fix.location_valid = true;
+  fix.location_fresh = true;
+  fix.lat_deg        = lat_deg;
+  fix.lng_deg        = lng_deg;
+  fix.satellites     = 6;
+  fix.hdop           = lround(hdop * 100);
+  return fix;
+}
+
+void setUp() {
+  beacon          = Configuration::Beacon();
+  beacon.filter   = true;
+  beacon.max_hdop = 5;
+  filter          = PositionFilter();
+  filter.begin(beacon);
+  epoch_ms = 0;
+}
+
+void tearDown() {
+}
+
+// Before the first good fix and after it, a run of poor ones never gives a
+// position to send, however long it lasts.
+void test_high_hdop_never_makes_a_position() {
+  for (int i = 0; i < 20; i++) {
+    GpsFix fix = burst(45.76 + i * 0.01, 4.84, 9.9);
+    TEST_ASSERT_FALSE(filter.update(fix));
+  }
+  GpsFix good = burst(45.75972, 4.84139, 1.2);
+  TEST_ASSERT_TRUE(filter.update(good));
+  TEST_ASSERT_FLOAT_WITHIN(1e-7, 45.75972, good.lat_deg);
+  for (int i = 0; i < 20; i++) {
+    GpsFix fix = burst(45.86, 4.94, 9.9);
+    TEST_ASSERT_FALSE(filter.update(fix));
+    TEST_ASSERT_FLOAT_WITHIN(1e-7, 45.86, fix.lat_deg);
+  }
+  // the estimate is still the good fix
+  GpsFix next = burst(45.75972, 4.84139, 1.2);
+  TEST_ASSERT_TRUE(filter.update(next));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 45.75972, next.lat_deg);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 4.84139, next.lng_deg);
+}
+
+// A good HDOP far from the estimate is dropped twice, the third in a row
+// starts the filter again from it.
+void test_gate_outliers_restart_after_three() {
+  GpsFix fix = burst(45.75972, 4.84139, 1.0);
+  TEST_ASSERT_TRUE(filter.update(fix));
+  for (int i = 0; i < 2; i++) {
+    fix = burst(45.80, 4.84139, 1.0);
+    TEST_ASSERT_FALSE(filter.update(fix));
+  }
+  fix = burst(45.80, 4.84139, 1.0);
+  TEST_ASSERT_TRUE(filter.update(fix));
+  TEST_ASSERT_FLOAT_WITHIN(1e-7, 45.80, fix.lat_deg);
+}
+
+// Poor fixes between two outliers do not make up the three of a restart.
+void test_high_hdop_does_not_count_toward_a_restart() {
+  GpsFix fix = burst(45.75972, 4.84139, 1.0);
+  TEST_ASSERT_TRUE(filter.update(fix));
+  fix = burst(45.80, 4.84139, 1.0);
+  TEST_ASSERT_FALSE(filter.update(fix));
+  for (int i = 0; i < 5; i++) {
+    fix = burst(45.80, 4.84139, 6.0);
+    TEST_ASSERT_FALSE(filter.update(fix));
+  }
+  fix = burst(45.80, 4.84139, 1.0);
+  TEST_ASSERT_FALSE(filter.update(fix));
+  fix = burst(45.80, 4.84139, 1.0);
+  TEST_ASSERT_TRUE(filter.update(fix));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_high_hdop_never_makes_a_position);
+  RUN_TEST(test_gate_outliers_restart_after_three);
+  RUN_TEST(test_high_hdop_does_not_count_toward_a_restart);
+  return UNITY_END();
+}
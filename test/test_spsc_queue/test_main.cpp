@@ -0,0 +1,130 @@
+// SpscQueue between a producer and a consumer thread, as the GPS task on
+// core 0 and loop() on core 1 use it. The native-tsan environment builds
+// with ThreadSanitizer, which reports any access to an item that the acquire
+// and release pair does not order: pio test -e native-tsan -f test_spsc_queue
+#include <unity.h>
+
+#include <thread>
+
+#include "gps_task.h"
+#include "spsc_queue.h"
+
+static const uint32_t Items = 200000;
+
+// Every field follows from the sequence number, an item read while the
+// producer still writes it does not add up.
+static void fill(GpsFix &fix, uint32_t sequence) {
+  memset(&fix, 0, sizeof(fix));
+  fix.epoch_ms   = sequence;
+  fix.second     = sequence % 60;
+  fix.lat_deg    = sequence * 1e-4;
+  fix.lng_deg    = -(double)sequence;
+  fix.altitude_m = sequence % 1000;
+  fix.satellites = sequence;
+  fix.hdop       = ~sequence;
+}
+
+static bool whole(const GpsFix &fix) {
+  uint32_t sequence = fix.epoch_ms;
+  return fix.second == sequence % 60 && fix.lat_deg == sequence * 1e-4 && fix.lng_deg == -(double)sequence && fix.altitude_m == sequence % 1000 && fix.satellites == sequence && fix.hdop == (int32_t)~sequence;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_holds_size_minus_one_in_order() {
+  SpscQueue<int, 4> queue;
+  int               item;
+  TEST_ASSERT_FALSE(queue.pop(item));
+  for (int i = 0; i < 3; i++) {
+    TEST_ASSERT_TRUE(queue.push(i));
+  }
+  TEST_ASSERT_FALSE(queue.push(3));
+  for (int round = 0; round < 10; round++) {
+    TEST_ASSERT_TRUE(queue.pop(item));
+    TEST_ASSERT_EQUAL(round, item);
+    TEST_ASSERT_TRUE(queue.push(round + 3));
+  }
+}
+
+// The producer waits for room: every item comes out once, in order and whole.
+void test_threads_lose_nothing() {
+  static SpscQueue<GpsFix, 8> queue;
+  std::thread                 producer([] {
+    GpsFix fix;
+    for (uint32_t i = 0; i < Items; i++) {
+      fill(fix, i);
+      while (!queue.push(fix)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t expected = 0;
+  uint32_t torn     = 0;
+  GpsFix   fix;
+  while (expected < Items) {
+    if (!queue.pop(fix)) {
+      std::this_thread::yield();
+      continue;
+    }
+    torn += !whole(fix);
+    if (fix.epoch_ms != expected) {
+      break;
+    }
+    expected++;
+  }
+  producer.join();
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_EQUAL(Items, expected);
+  TEST_ASSERT_FALSE(queue.pop(fix));
+}
+
+// As GpsTask: a burst that finds the queue full is dropped, what comes out
+// is whole and in order, and nothing is counted twice.
+void test_threads_drop_when_full() {
+  static SpscQueue<GpsFix, 8> queue;
+  static std::atomic<bool>    done(false);
+  uint32_t                    dropped = 0;
+  std::thread                 producer([&dropped] {
+    GpsFix fix;
+    for (uint32_t i = 0; i < Items; i++) {
+      fill(fix, i);
+      dropped += !queue.push(fix);
+    }
+    done.store(true, std::memory_order_release);
+  });
+  uint32_t received = 0;
+  uint32_t torn     = 0;
+  uint32_t disorder = 0;
+  int64_t  last     = -1;
+  GpsFix   fix;
+  while (true) {
+    bool finished = done.load(std::memory_order_acquire);
+    while (queue.pop(fix)) {
+      torn += !whole(fix);
+      disorder += (int64_t)fix.epoch_ms <= last;
+      last = fix.epoch_ms;
+      received++;
+    }
+    if (finished) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  producer.join();
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_EQUAL(0, disorder);
+  TEST_ASSERT_EQUAL(Items, received + dropped);
+  TEST_ASSERT_GREATER_THAN(0, received);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_holds_size_minus_one_in_order);
+  RUN_TEST(test_threads_lose_nothing);
+  RUN_TEST(test_threads_drop_when_full);
+  return UNITY_END();
+}
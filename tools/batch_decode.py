@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""Lists the positions of the beacons sent with batched fixes.
+
+Reads lines holding a frame, "CALL>DEST,PATH:info" as APRS-IS gives it or as
+the simulator prints it with -v, and prints each position, then the fixes of
+its batch (src/position_batch.h has the format) as seconds before the frame,
+latitude and longitude. Lines without a position are skipped.
+
+    .pio/build/native/program --hours 24 -v | tools/batch_decode.py
+    tools/batch_decode.py --self-test
+"""
+
+import argparse
+import random
+import re
+import sys
+
+FRAME = re.compile(r"([A-Z0-9-]+)>([A-Z0-9-]+)[^:]*:(.*)")
+BATCH = re.compile(r"\}((?:[!-{]{6})+)\}")
+OFFSET = 4140
+
+
+def base91(chars):
+    value = 0
+    for c in chars:
+        value = value * 91 + ord(c) - 33
+    return value
+
+
+def uncompressed(info):
+    """!DDMM.mmN/DDDMM.mmE, returns the position and its length."""
+    lat = int(info[0:2]) + float(info[2:7]) / 60
+    lng = int(info[9:12]) + float(info[12:17]) / 60
+    if info[7] == "S":
+        lat = -lat
+    if info[17] == "W":
+        lng = -lng
+    return lat, lng, 19
+
+
+def compressed(info):
+    lat = 90 - base91(info[1:5]) / 380926.0
+    lng = -180 + base91(info[5:9]) / 190463.0
+    return lat, lng, 13
+
+
+def mic_e(destination, info):
+    digits = []
+    for c in destination[:6]:
+        if "0" <= c <= "9":
+            digits.append(ord(c) - ord("0"))
+        elif "A" <= c <= "J":
+            digits.append(ord(c) - ord("A"))
+        elif "P" <= c <= "Y":
+            digits.append(ord(c) - ord("P"))
+        else:
+            digits.append(0)
+    lat = digits[0] * 10 + digits[1] + (digits[2] * 10 + digits[3] + (digits[4] * 10 + digits[5]) / 100.0) / 60
+    if destination[3] < "P":
+        lat = -lat
+    degrees = ord(info[1]) - 28
+    if destination[4] >= "P":
+        degrees += 100
+    if 180 <= degrees <= 189:
+        degrees -= 80
+    elif 190 <= degrees <= 199:
+        degrees -= 190
+    minutes = ord(info[2]) - 28
+    if minutes >= 60:
+        minutes -= 60
+    lng = degrees + (minutes + (ord(info[3]) - 28) / 100.0) / 60
+    if destination[5] >= "P":
+        lng = -lng
+    return lat, lng, 9
+
+
+def position(destination, info):
+    """Latitude, longitude and the rest of the information field, or None."""
+    if info[:1] in ("`", "'"):
+        lat, lng, length = mic_e(destination, info)
+    elif info[:1] in ("!", "=", "/", "@"):
+        body = info[1:] if info[0] in "!=" else info[8:]
+        if body[:1].isdigit():
+            lat, lng, length = uncompressed(body)
+        else:
+            lat, lng, length = compressed(body)
+        info = body
+    else:
+        return None
+    return lat, lng, info[length:]
+
+
+def batch(lat, lng, rest):
+    """The fixes of the batch after the position, newest first."""
+    match = BATCH.match(rest) or BATCH.search(rest)
+    if not match:
+        return []
+    fixes = []
+    age = 0
+    lat_e5 = round(lat * 1e5)
+    lng_e5 = round(lng * 1e5)
+    data = match.group(1)
+    for i in range(0, len(data), 6):
+        age += base91(data[i : i + 2])
+        lat_e5 += base91(data[i + 2 : i + 4]) - OFFSET
+        lng_e5 += base91(data[i + 4 : i + 6]) - OFFSET
+        fixes.append((age, lat_e5 / 1e5, lng_e5 / 1e5))
+    return fixes
+
+
+def decode(line):
+    # the LoRa APRS "<\xFF\x01" prefix, raw or as the simulator prints it
+    line = re.sub(r"\\x[0-9A-F]{2}|[\x00-\x1f\x7f-\xff]", " ", line)
+    match = FRAME.search(line)
+    if not match:
+        return None
+    source, destination, info = match.groups()
+    found = position(destination, info)
+    if not found:
+        return None
+    lat, lng, rest = found
+    return source, lat, lng, batch(lat, lng, rest)
+
+
+def encode(fixes):
+    """Batch of (utc, lat, lng) fixes, newest first, as src/position_batch.cpp."""
+
+    def chars(value):
+        return chr(33 + value // 91) + chr(33 + value % 91)
+
+    out = ""
+    for later, fix in zip(fixes, fixes[1:]):
+        values = (
+            later[0] - fix[0],
+            round(fix[1] * 1e5) - round(later[1] * 1e5) + OFFSET,
+            round(fix[2] * 1e5) - round(later[2] * 1e5) + OFFSET,
+        )
+        if any(v < 0 or v > 2 * OFFSET for v in values):
+            break
+        text = out + "".join(chars(v) for v in values)
+        if misread(text, len(out)):
+            break
+        out = text
+    return "}%s}" % out if out else ""
+
+
+def misread(text, start):
+    """A DAO "!xyz!" or an altitude "/A=" completed from start on."""
+    for i in range(start, len(text)):
+        if text[i] == "!" and i >= 4 and text[i - 4] == "!":
+            return True
+        if i >= 2 and text[i - 2 : i + 1] == "/A=":
+            return True
+    return False
+
+
+def self_test():
+    track = [(1200 - 60 * i, 48.12345 + 0.0004 * i, -1.54321 - 0.0007 * i * i) for i in range(9)]
+    # the compressed position gives the head to 1e-5 degree at most
+    head = "!/%s%sb!!T" % (
+        "".join(chr(33 + (round(380926 * (90 - track[0][1])) // 91 ** k) % 91) for k in (3, 2, 1, 0)),
+        "".join(chr(33 + (round(190463 * (180 + track[0][2])) // 91 ** k) % 91) for k in (3, 2, 1, 0)),
+    )
+    frame = "N0CALL-7>APLORA,WIDE1-1:" + head + encode(track) + "LoRa Beacon"
+    source, lat, lng, fixes = decode(frame)
+    assert source == "N0CALL-7"
+    assert abs(lat - track[0][1]) < 2e-5 and abs(lng - track[0][2]) < 2e-5, (lat, lng)
+    assert len(fixes) == len(track) - 1, fixes
+    for (age, f_lat, f_lng), fix in zip(fixes, track[1:]):
+        assert age == track[0][0] - fix[0], (age, fix)
+        assert abs(f_lat - fix[1]) < 3e-5 and abs(f_lng - fix[2]) < 3e-5, (f_lat, f_lng, fix)
+    # a jump that does not fit ends the batch
+    assert len(decode("A>APLORA:" + head + encode(track[:3] + [(0, 10.0, 10.0)]))[3]) == 2
+    # so does a fix that would read as a DAO (dt 0 and a longitude step of
+    # -0.041 degree give "!!..!.") or an altitude (1306 s is "/A")
+    dao = track[:3] + [(track[2][0], track[2][1], track[2][2] - 0.04100)]
+    altitude = track[:3] + [(track[2][0] - 1306, track[2][1] - 0.01540, track[2][2])]
+    for cut in (dao, altitude):
+        assert encode(cut[2:]) == "", encode(cut[2:])
+        assert len(decode("A>APLORA:" + head + encode(cut))[3]) == 2
+    for _ in range(2000):
+        walk = [(100000, 45.0, 5.0)]
+        for _ in range(8):
+            t, lat, lng = walk[-1]
+            walk.append((t - random.randint(0, 2000), lat + random.randint(-4140, 4140) / 1e5, lng + random.randint(-4140, 4140) / 1e5))
+        data = encode(walk)
+        assert not re.search(r"![\x21-\x7b][\x20-\x7b]{2}!|/A=", data), data
+    # frames of src/frame_builder.cpp and src/position_batch.cpp, fixes
+    # 30 s apart at 45.12310 -12.74410, 45.12290 -12.74390 and the head at
+    # 45.12325 -12.74370 sent to 0.01 minute
+    expected = [(30, 45.12290, -12.74390), (60, 45.12310, -12.74410)]
+    for frame in (
+        'N0CALL-7>TU0W3Y,WIDE1-1:`(HZlNvb/"54}}!?N+N:!?NbN:}LoRa',
+        "N0CALL-7>APLORA,WIDE1-1:!4507.39N/01244.62Wb090/005/A=000393}!?N+N:!?NbN:}",
+    ):
+        source, lat, lng, fixes = decode(frame)
+        assert abs(lat - 45.12325) < 1e-4 and abs(lng + 12.74370) < 1e-4, (lat, lng)
+        assert [age for age, _, _ in fixes] == [30, 60], fixes
+        for (_, f_lat, f_lng), fix in zip(fixes, expected):
+            assert abs(f_lat - fix[1]) < 1e-4 and abs(f_lng - fix[2]) < 1e-4, (f_lat, f_lng, fix)
+    print("self test passed")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("file", nargs="?", help="frames, one per line (default stdin)")
+    parser.add_argument("--self-test", action="store_true", help="check the decoder against the encoder")
+    args = parser.parse_args()
+
+    if args.self_test:
+        self_test()
+        return
+    lines = open(args.file, errors="replace") if args.file else sys.stdin
+    for line in lines:
+        decoded = decode(line.rstrip("\n"))
+        if not decoded:
+            continue
+        source, lat, lng, fixes = decoded
+        print("%s %.5f %.5f" % (source, lat, lng))
+        for age, f_lat, f_lng in fixes:
+            print("  -%ds %.5f %.5f" % (age, f_lat, f_lng))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Compares two runs of the benchmarks and tells the regressions.
+
+The runs are the output of src/bench/bench.cpp, on the host or the serial
+console of the T-Beam: a BENCH line per case with its time per call, heap
+allocations per call and peak heap use. A case is a regression when it got
+slower by more than the threshold, or allocates more or a larger peak.
+
+    tools/bench_compare.py old.txt new.txt
+    tools/bench_compare.py old.txt new.txt --threshold 5
+    tools/bench_compare.py --self-test
+"""
+
+import argparse
+import re
+import sys
+
+LINE = re.compile(r"BENCH\s+(\S+)\s+([\d.]+) ns/op\s+([\d.]+) allocs/op\s+(\d+) B peak")
+
+
+def parse(text):
+    """Cases as name: (ns, allocs, peak), the last run of a name wins."""
+    return {m.group(1): (float(m.group(2)), float(m.group(3)), int(m.group(4))) for m in LINE.finditer(text)}
+
+
+def compare(old, new, threshold):
+    """Report lines and the number of regressions."""
+    lines = []
+    regressions = 0
+    for name in sorted(set(old) | set(new)):
+        if name not in new:
+            lines.append("%-28s gone" % name)
+            continue
+        if name not in old:
+            lines.append("%-28s new   %12.1f ns/op" % (name, new[name][0]))
+            continue
+        (ns0, allocs0, peak0), (ns1, allocs1, peak1) = old[name], new[name]
+        change = 100.0 * (ns1 - ns0) / ns0 if ns0 else 0.0
+        flags = []
+        if change > threshold:
+            flags.append("slower")
+        if allocs1 > allocs0:
+            flags.append("allocs %.2f -> %.2f" % (allocs0, allocs1))
+        if peak1 > peak0:
+            flags.append("peak %d -> %d B" % (peak0, peak1))
+        regressions += bool(flags)
+        lines.append("%-28s %12.1f -> %12.1f ns/op %+7.1f%%  %s" % (name, ns0, ns1, change, ", ".join(flags) or "ok"))
+    return lines, regressions
+
+
+def self_test():
+    old = parse(
+        "bench on the host\n"
+        "BENCH frame.position_compressed           137.3 ns/op     0.00 allocs/op        0 B peak\n"
+        "BENCH config.read_cached                  189.3 ns/op     2.00 allocs/op      233 B peak\n"
+        "      (40 sentences, 2395 bytes per op)\n"
+        "BENCH gps.encode_corpus                 12000.0 ns/op     0.00 allocs/op        0 B peak\n"
+    )
+    assert len(old) == 3 and old["config.read_cached"] == (189.3, 2.0, 233)
+    new = dict(old)
+    assert compare(old, new, 10)[1] == 0
+    new["frame.position_compressed"] = (160.0, 0.0, 0)
+    new["config.read_cached"] = (180.0, 3.0, 233)
+    new["gps.encode_corpus"] = (12500.0, 0.0, 0)
+    lines, regressions = compare(old, new, 10)
+    assert regressions == 2, lines
+    assert compare(old, new, 5)[1] == 2 and compare(old, {}, 10)[1] == 0
+    print("self test passed")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("old", nargs="?", help="output of the reference run")
+    parser.add_argument("new", nargs="?", help="output of the run to check")
+    parser.add_argument("--threshold", type=float, default=10, help="percent of time per call allowed (default 10)")
+    parser.add_argument("--self-test", action="store_true", help="check the parser and the comparison")
+    args = parser.parse_args()
+
+    if args.self_test:
+        self_test()
+        return
+    if not args.new:
+        parser.error("two runs are needed")
+    runs = []
+    for name in (args.old, args.new):
+        with open(name, errors="replace") as f:
+            runs.append(parse(f.read()))
+        if not runs[-1]:
+            sys.exit("%s: no BENCH line" % name)
+    lines, regressions = compare(runs[0], runs[1], args.threshold)
+    print("\n".join(lines))
+    if regressions:
+        sys.exit("%d regressions" % regressions)
+
+
+if __name__ == "__main__":
+    main()
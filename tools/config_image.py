@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Writes the binary configuration image of a beacon.json.
+
+The firmware keeps this image in NVS and only parses the JSON again when the
+file changes (src/config_image.h has the layout). The defaults below are those
+of src/configuration.cpp, keep both in step.
+
+    tools/config_image.py data/beacon.json -o config.bin
+    tools/config_image.py data/beacon.json --compare sim/nvs.beacon.config
+"""
+
+import argparse
+import json
+import struct
+import sys
+import zlib
+
+MAGIC = b"BCFG"
+VERSION = 9
+
+# everything after the 12 byte header, up to the crc
+BODY = struct.Struct("<16s48s96s4s4s24i3f28i4B")
+HEADER = struct.Struct("<4sHHI")
+SIZE = HEADER.size + BODY.size + 4
+
+FORMATS = {"compressed": 1, "mic-e": 2}
+TIMEOUT_ACTIONS = {"last_position": 1, "status": 2}
+POWER_MODES = {"backup": 1, "cyclic": 2}
+TELEMETRY_FORMATS = {"telemetry": 1}
+
+FLAG_DEBUG = 0x01
+FLAG_DEEP_SLEEP = 0x02
+FLAG_SMART_BEACON = 0x04
+FLAG_LORA_CRC = 0x08
+FLAG_PTT = 0x10
+FLAG_PTT_REVERSE = 0x20
+FLAG_BUTTON_TX = 0x40
+FLAG_LORA_LBT = 0x80
+
+
+def lookup(doc, path):
+    for key in path.split("."):
+        if not isinstance(doc, dict) or key not in doc:
+            return None
+        doc = doc[key]
+    return doc
+
+
+def value(doc, path, default):
+    """data[...] | default of ArduinoJson: the default unless the type fits."""
+    v = lookup(doc, path)
+    if isinstance(default, bool):
+        return v if isinstance(v, bool) else default
+    if isinstance(v, bool):
+        return default
+    if isinstance(default, int):
+        return v if isinstance(v, int) else default
+    if isinstance(default, float):
+        return float(v) if isinstance(v, (int, float)) else default
+    return v if isinstance(v, str) else default
+
+
+def text(doc, path, size):
+    """as<String>(), which gives "null" for a missing member."""
+    v = lookup(doc, path)
+    s = "null" if v is None else v
+    if not isinstance(s, str):
+        raise ValueError("%s is not a string" % path)
+    raw = s.encode()
+    if len(raw) >= size:
+        raise ValueError("%s longer than %d bytes" % (path, size - 1))
+    return raw
+
+
+def build(source):
+    doc = json.loads(source)
+    sb = "beacon.smart_beacon."
+    flags = 0
+    for path, default, flag in (
+        ("debug", False, FLAG_DEBUG),
+        ("deep_sleep", False, FLAG_DEEP_SLEEP),
+        (sb + "active", False, FLAG_SMART_BEACON),
+        ("lora.crc", True, FLAG_LORA_CRC),
+        ("ptt_output.active", False, FLAG_PTT),
+        ("ptt_output.reverse", False, FLAG_PTT_REVERSE),
+        ("button.tx", False, FLAG_BUTTON_TX),
+        ("lora.listen_before_talk", False, FLAG_LORA_LBT),
+    ):
+        if value(doc, path, default):
+            flags |= flag
+
+    body = BODY.pack(
+        text(doc, "beacon.callsign", 16),
+        text(doc, "beacon.path", 48),
+        text(doc, "beacon.message", 96),
+        text(doc, "beacon.symbol", 4),
+        text(doc, "beacon.overlay", 4),
+        value(doc, "beacon.timeout", 1),
+        value(doc, "beacon.positiondilution", 1),
+        value(doc, "beacon.max_backoff", 8),
+        int(value(doc, "beacon.slotted", False)),
+        value(doc, "beacon.batch_interval", 0),
+        value(doc, "beacon.batch_size", 8),
+        int(value(doc, "beacon.filter", False)),
+        value(doc, "beacon.min_distance", 0),
+        value(doc, "beacon.max_skip", 5),
+        value(doc, sb + "slow_rate", 120),
+        value(doc, sb + "slow_speed", 10),
+        value(doc, sb + "fast_rate", 10),
+        value(doc, sb + "fast_speed", 100),
+        value(doc, sb + "turn_min", 25),
+        value(doc, sb + "turn_slope", 410),
+        value(doc, sb + "turn_time", 15),
+        value(doc, "lora.frequency_rx", 433775000),
+        value(doc, "lora.frequency_tx", 433775000),
+        value(doc, "lora.power", 20),
+        value(doc, "lora.spreading_factor", 12),
+        value(doc, "lora.signal_bandwidth", 125000),
+        value(doc, "lora.coding_rate4", 5),
+        value(doc, "lora.preamble_length", 8),
+        value(doc, "lora.max_defer", 30),
+        value(doc, "lora.duty_cycle", 0.0),
+        value(doc, "lora.tx_current", 120.0),
+        value(doc, "beacon.max_hdop", 5.0),
+        value(doc, "gps.update_period", 10),
+        value(doc, "gps.baud", 38400),
+        value(doc, "cpu.low_mhz", 80),
+        value(doc, "cpu.high_mhz", 240),
+        value(doc, "ptt_output.io_pin", 4),
+        value(doc, "ptt_output.start_delay", 0),
+        value(doc, "ptt_output.end_delay", 0),
+        int(value(doc, "button.alt_message", False)),
+        int(value(doc, "governor.active", False)),
+        value(doc, "governor.capacity", 0),
+        value(doc, "governor.hysteresis", 5),
+        value(doc, "governor.saving.below", 40),
+        value(doc, "governor.saving.rate", 2),
+        value(doc, "governor.saving.power", 17),
+        value(doc, "governor.saving.spreading_factor", 0),
+        int(value(doc, "governor.saving.display", False)),
+        value(doc, "governor.survival.below", 15),
+        value(doc, "governor.survival.rate", 4),
+        value(doc, "governor.survival.power", 10),
+        value(doc, "governor.survival.spreading_factor", 0),
+        int(value(doc, "governor.survival.display", False)),
+        int(value(doc, "telemetry.active", False)),
+        TELEMETRY_FORMATS.get(value(doc, "telemetry.format", "weather"), 0),
+        value(doc, "telemetry.rate", 1800),
+        value(doc, "telemetry.oversampling", 1),
+        value(doc, "telemetry.filter", 0),
+        int(value(doc, "track.active", False)),
+        value(doc, "track.max_kb", 512),
+        FORMATS.get(value(doc, "beacon.format", "uncompressed"), 0),
+        TIMEOUT_ACTIONS.get(value(doc, "beacon.timeout_action", "sleep"), 0),
+        POWER_MODES.get(value(doc, "gps.power_mode", "off"), 0),
+        flags,
+    )
+    image = HEADER.pack(MAGIC, VERSION, SIZE, zlib.crc32(source)) + body
+    return image + struct.pack("<I", zlib.crc32(image))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("json", help="beacon.json")
+    parser.add_argument("-o", "--output", help="image file to write")
+    parser.add_argument("--compare", metavar="IMAGE", help="check that IMAGE is the image of the JSON")
+    args = parser.parse_args()
+
+    with open(args.json, "rb") as f:
+        source = f.read()
+    try:
+        image = build(source)
+    except ValueError as e:
+        sys.exit("%s: %s" % (args.json, e))
+
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(image)
+    if args.compare:
+        with open(args.compare, "rb") as f:
+            other = f.read()
+        if other != image:
+            diff = [i for i in range(min(len(other), len(image))) if other[i] != image[i]]
+            sys.exit("%s differs (%d bytes against %d, first difference at %s)" % (args.compare, len(other), len(image), diff[0] if diff else "the end"))
+        print("%s matches" % args.compare)
+    if not args.output and not args.compare:
+        print("%d bytes, source crc %08x, crc %08x" % (len(image), zlib.crc32(source), zlib.crc32(image[:-4])))
+
+
+if __name__ == "__main__":
+    main()
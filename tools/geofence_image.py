@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+"""Writes the geofence file of the zones of a JSON file.
+
+The firmware looks up the zone of each fix in /geofence.bin on SPIFFS
+(src/geofence.h has the layout): a grid over the fences lists in each cell
+the fences whose bounding box overlaps it, so that a lookup only reads one
+cell and its few fences. Put the output in data/ and upload the file system
+image. The zones are looked up in their order, the first one holding the
+position wins, so list the small ones inside larger ones first.
+
+    {"zones": [{"name": "depot", "rate": 3600, "message": "At the depot",
+                "fences": [[[48.1102, -1.6803], [48.1110, -1.6790], ...]]}]}
+
+    tools/geofence_image.py zones.json -o data/geofence.bin
+    tools/geofence_image.py --self-test
+    tools/geofence_image.py --fixture test/test_geofence
+"""
+
+import argparse
+import json
+import math
+import random
+import struct
+import sys
+import time
+
+MAGIC = b"GEO1"
+HEADER = struct.Struct("<4sHHHHiiii")
+ZONE = struct.Struct("<16si48s")
+FENCE = struct.Struct("<HHiiiiI")
+CELL = struct.Struct("<IHH")
+POINT = struct.Struct("<iih")
+MAX_CANDIDATES = 32  # Geofence::MaxCandidates
+MAX_CELLS = 16384
+
+
+def fixed(degrees):
+    """Degrees in 1e-5, as src/geofence.cpp rounds the fixes."""
+    return int(math.floor(degrees * 1e5 + 0.5))
+
+
+def load(doc):
+    """Zones as (name, rate, message) and fences as (zone, [(lat, lng)])."""
+    zones = []
+    fences = []
+    for index, zone in enumerate(doc.get("zones", [])):
+        name = zone.get("name", "zone%d" % index)
+        message = zone.get("message", "")
+        if len(name.encode()) >= 16 or len(message.encode()) >= 48:
+            raise ValueError("zone %s: name or message too long" % name)
+        zones.append((name, int(zone.get("rate", 0)), message))
+        for polygon in zone.get("fences", []):
+            vertices = [(fixed(lat), fixed(lng)) for lat, lng in polygon]
+            if len(vertices) > 1 and vertices[0] == vertices[-1]:
+                vertices.pop()
+            if len(vertices) < 3 or len(vertices) > 65535:
+                raise ValueError("zone %s: a fence needs 3 to 65535 vertices" % name)
+            fences.append((index, vertices))
+    if len(zones) > 65535 or len(fences) > 65535:
+        raise ValueError("too many zones or fences")
+    return zones, fences
+
+
+def bounds(vertices):
+    lats = [v[0] for v in vertices]
+    lngs = [v[1] for v in vertices]
+    return min(lats), max(lats), min(lngs), max(lngs)
+
+
+def grid(fences, cells):
+    """Origin, cell sizes and dimensions for about that many cells."""
+    boxes = [bounds(v) for _, v in fences]
+    lat0 = min(b[0] for b in boxes)
+    lng0 = min(b[2] for b in boxes)
+    span_lat = max(b[1] for b in boxes) - lat0 + 1
+    span_lng = max(b[3] for b in boxes) - lng0 + 1
+    cols = max(1, min(cells, int(round(math.sqrt(cells * span_lng / span_lat)))))
+    rows = max(1, min(cells // cols, cells))
+    cell_lat = -(-span_lat // rows)
+    cell_lng = -(-span_lng // cols)
+    rows = -(-span_lat // cell_lat)
+    cols = -(-span_lng // cell_lng)
+    return lat0, lng0, cell_lat, cell_lng, rows, cols
+
+
+def index(fences, layout):
+    lat0, lng0, cell_lat, cell_lng, rows, cols = layout
+    lists = [[] for _ in range(rows * cols)]
+    for i, (_, vertices) in enumerate(fences):
+        lat_min, lat_max, lng_min, lng_max = bounds(vertices)
+        for row in range((lat_min - lat0) // cell_lat, (lat_max - lat0) // cell_lat + 1):
+            for col in range((lng_min - lng0) // cell_lng, (lng_max - lng0) // cell_lng + 1):
+                lists[row * cols + col].append(i)
+    return lists
+
+
+def build(doc):
+    zones, fences = load(doc)
+    if not fences:
+        layout = (0, 0, 1, 1, 1, 1)
+        lists = [[]]
+    else:
+        # finer until no cell lists more fences than the firmware keeps
+        cells = min(MAX_CELLS, max(1, 2 * len(fences)))
+        while True:
+            layout = grid(fences, cells)
+            lists = index(fences, layout)
+            if max(len(l) for l in lists) <= MAX_CANDIDATES:
+                break
+            if cells >= MAX_CELLS:
+                raise ValueError("more than %d fences overlap in %d cells" % (MAX_CANDIDATES, MAX_CELLS))
+            cells = min(MAX_CELLS, cells * 4)
+    lat0, lng0, cell_lat, cell_lng, rows, cols = layout
+
+    offset = HEADER.size + len(zones) * ZONE.size + len(fences) * FENCE.size + len(lists) * CELL.size
+    cells = b""
+    ids = b""
+    for l in lists:
+        cells += CELL.pack(offset + len(ids), len(l), 0)
+        ids += struct.pack("<%dH" % len(l), *l)
+    offset += len(ids)
+    table = b""
+    vertices = b""
+    for zone, polygon in fences:
+        lat_min, lat_max, lng_min, lng_max = bounds(polygon)
+        table += FENCE.pack(zone, len(polygon), lat_min, lat_max, lng_min, lng_max, offset + len(vertices))
+        vertices += b"".join(struct.pack("<ii", lat, lng) for lat, lng in polygon)
+
+    out = HEADER.pack(MAGIC, len(zones), len(fences), rows, cols, lat0, lng0, cell_lat, cell_lng)
+    out += b"".join(ZONE.pack(n.encode(), r, m.encode()) for n, r, m in zones)
+    return out + table + cells + ids + vertices
+
+
+def contains(vertices, lat, lng):
+    """Crossing number in integers, as Geofence::contains()."""
+    inside = False
+    a = vertices[-1]
+    for b in vertices:
+        if (a[0] > lat) != (b[0] > lat):
+            east = (lng - a[1]) * (b[0] - a[0])
+            cross = (lat - a[0]) * (b[1] - a[1])
+            if (east < cross) if b[0] > a[0] else (east > cross):
+                inside = not inside
+        a = b
+    return inside
+
+
+class Reader:
+    """Looks up the file as Geofence::lookup() does."""
+
+    def __init__(self, data):
+        self.data = data
+        _, self.zones, self.fences, self.rows, self.cols, self.lat0, self.lng0, self.cell_lat, self.cell_lng = HEADER.unpack_from(data)
+
+    def lookup(self, lat, lng):
+        if lat < self.lat0 or lng < self.lng0:
+            return -1
+        row = (lat - self.lat0) // self.cell_lat
+        col = (lng - self.lng0) // self.cell_lng
+        if row >= self.rows or col >= self.cols:
+            return -1
+        fences = HEADER.size + self.zones * ZONE.size
+        offset, count, _ = CELL.unpack_from(self.data, fences + self.fences * FENCE.size + (row * self.cols + col) * CELL.size)
+        for i in struct.unpack_from("<%dH" % count, self.data, offset):
+            zone, n, lat_min, lat_max, lng_min, lng_max, at = FENCE.unpack_from(self.data, fences + i * FENCE.size)
+            if lat_min <= lat <= lat_max and lng_min <= lng <= lng_max:
+                if contains(list(struct.iter_unpack("<ii", self.data[at : at + 8 * n])), lat, lng):
+                    return zone
+        return -1
+
+
+def sample(seed, zone_count, point_count):
+    """Random star shaped zones, and points over them and next to their
+    vertices with the zone the tool finds for each."""
+    rng = random.Random(seed)
+    zones = []
+    for z in range(zone_count):
+        fences = []
+        for _ in range(rng.randint(1, 8)):
+            lat = 48 + rng.uniform(-0.5, 0.5)
+            lng = -1.5 + rng.uniform(-0.8, 0.8)
+            size = rng.uniform(0.001, 0.05)
+            n = rng.randint(3, 40)
+            # star shaped, so neither convex nor aligned on the grid
+            fences.append([(lat + size * rng.uniform(0.3, 1) * math.sin(2 * math.pi * k / n), lng + size * rng.uniform(0.3, 1) * math.cos(2 * math.pi * k / n)) for k in range(n)])
+        zones.append({"name": "z%d" % z, "rate": 60 * z, "fences": fences})
+    doc = {"zones": zones}
+    data = build(doc)
+    _, fences = load(doc)
+    points = [(fixed(48 + rng.uniform(-0.6, 0.6)), fixed(-1.5 + rng.uniform(-0.9, 0.9))) for _ in range(point_count)]
+    for _, vertices in fences[:50]:
+        points += [(lat + rng.randint(-2, 2), lng + rng.randint(-2, 2)) for lat, lng in vertices]
+    return data, fences, points
+
+
+def self_test():
+    data, fences, points = sample(7, 40, 20000)
+    reader = Reader(data)
+    hits = 0
+    for lat, lng in points:
+        expected = next((zone for zone, vertices in fences if contains(vertices, lat, lng)), -1)
+        assert reader.lookup(lat, lng) == expected, (lat, lng, expected)
+        hits += expected >= 0
+    assert hits > 100, hits
+    # a square, its corner and edges on the integer grid
+    square = Reader(build({"zones": [{"name": "sq", "fences": [[[0, 0], [0, 0.0001], [0.0001, 0.0001], [0.0001, 0]]]}]}))
+    assert square.lookup(5, 5) == 0 and square.lookup(11, 5) == -1 and square.lookup(5, -1) == -1
+    assert Reader(build({"zones": []})).lookup(0, 0) == -1
+    start = time.perf_counter()
+    for lat, lng in points[:5000]:
+        reader.lookup(lat, lng)
+    rate = 5000 / (time.perf_counter() - start)
+    print("self test passed, %d fences in %d bytes, %d Python lookups/s" % (len(fences), len(data), rate))
+
+
+def write_fixture(directory):
+    """The file and its points for test/test_geofence, each point as latitude,
+    longitude and the zone of its first fence holding it, int32 int32 int16."""
+    data, fences, points = sample(11, 16, 4000)
+    with open(directory + "/geofence.bin", "wb") as f:
+        f.write(data)
+    with open(directory + "/points.bin", "wb") as f:
+        for lat, lng in points:
+            f.write(POINT.pack(lat, lng, next((zone for zone, vertices in fences if contains(vertices, lat, lng)), -1)))
+    print("%d fences in %d bytes, %d points" % (len(fences), len(data), len(points)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("json", nargs="?", help="zones and their fences")
+    parser.add_argument("-o", "--output", help="geofence file to write")
+    parser.add_argument("--self-test", action="store_true", help="check the index against every fence")
+    parser.add_argument("--fixture", metavar="DIR", help="write the file and points of the firmware test")
+    args = parser.parse_args()
+
+    if args.self_test:
+        self_test()
+        return
+    if args.fixture:
+        write_fixture(args.fixture)
+        return
+    if not args.json:
+        parser.error("the zones JSON is needed")
+    with open(args.json) as f:
+        doc = json.load(f)
+    try:
+        data = build(doc)
+    except ValueError as e:
+        sys.exit("%s: %s" % (args.json, e))
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(data)
+    reader = Reader(data)
+    print("%d zones, %d fences, %dx%d cells, %d bytes" % (reader.zones, reader.fences, reader.rows, reader.cols, len(data)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Decodes the track log of the tracker, from the serial port or a file.
+
+The pages are those of src/track_log.h: 256 bytes, a whole fix, up to 28
+changes from the fix before and a CRC-32. Pages that fail their CRC, cut
+short by a power loss, are left out and counted. The fixes are written as
+CSV (utc, latitude, longitude, altitude in m, speed in km/h) or GPX.
+
+    tools/track_export.py --port /dev/ttyUSB0 -o trip.csv
+    tools/track_export.py sim/track.old sim/track.log --gpx -o trip.gpx
+    tools/track_export.py --self-test
+"""
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = 0x314B5254  # "TRK1"
+PAGE_SIZE = 256
+RECORDS = 28
+HEADER = struct.Struct("<IIIiihBB")
+RECORD = struct.Struct("<HhhbB")
+
+
+def pages(data):
+    """Valid pages as (sequence, fixes), and the number of bad ones."""
+    found = []
+    bad = 0
+    for at in range(0, len(data) - PAGE_SIZE + 1, PAGE_SIZE):
+        page = data[at : at + PAGE_SIZE]
+        magic, sequence, utc, lat, lng, altitude, speed, count = HEADER.unpack_from(page)
+        if magic != MAGIC or count > RECORDS or struct.unpack_from("<I", page, PAGE_SIZE - 4)[0] != zlib.crc32(page[:-4]):
+            # an erased or padded page is no loss
+            bad += any(page)
+            continue
+        fixes = [(utc, lat, lng, altitude, speed)]
+        for i in range(count):
+            dt, d_lat, d_lng, d_alt, speed = RECORD.unpack_from(page, HEADER.size + i * RECORD.size)
+            utc, lat, lng, altitude = utc + dt, lat + d_lat, lng + d_lng, altitude + d_alt
+            fixes.append((utc, lat, lng, altitude, speed))
+        found.append((sequence, fixes))
+    return found, bad
+
+
+def decode(data):
+    """Fixes in the order of the pages, the page being filled included once."""
+    found, bad = pages(data)
+    fixes = []
+    seen = set()
+    for sequence, page in sorted(found, key=lambda p: p[0]):
+        if sequence in seen:
+            continue
+        seen.add(sequence)
+        fixes += page
+    return fixes, bad
+
+
+def encode(fixes, sequence=0):
+    """Pages of the fixes, as src/track_log.cpp writes them."""
+    out = b""
+    page = None
+    for fix in fixes:
+        if page is not None:
+            last = page[-1]
+            d = (fix[0] - last[0], fix[1] - last[1], fix[2] - last[2], fix[3] - last[3])
+            if 0 < d[0] <= 0xFFFF and all(abs(v) <= 0x7FFF for v in d[1:3]) and abs(d[3]) <= 0x7F and len(page) <= RECORDS:
+                page.append(fix)
+                if len(page) == RECORDS + 1:
+                    out += seal(page, sequence)
+                    sequence += 1
+                    page = None
+                continue
+            out += seal(page, sequence)
+            sequence += 1
+        page = [fix]
+    if page:
+        out += seal(page, sequence)
+    return out
+
+
+def seal(page, sequence):
+    first = page[0]
+    data = HEADER.pack(MAGIC, sequence, first[0], first[1], first[2], first[3], first[4], len(page) - 1)
+    for last, fix in zip(page, page[1:]):
+        data += RECORD.pack(fix[0] - last[0], fix[1] - last[1], fix[2] - last[2], fix[3] - last[3], fix[4])
+    data += bytes(PAGE_SIZE - 4 - len(data))
+    return data + struct.pack("<I", zlib.crc32(data))
+
+
+def download(port):
+    import serial  # pyserial, only needed for the download
+
+    with serial.Serial(port, 115200, timeout=5) as link:
+        link.reset_input_buffer()
+        link.write(b"track\n")
+        while True:
+            line = link.readline()
+            if not line:
+                sys.exit("%s: no answer to the track command" % port)
+            if line.startswith(b"TRACK "):
+                break
+        size, baud = (int(v) for v in line.split()[1:3])
+        link.baudrate = baud
+        data = b""
+        while len(data) < size:
+            chunk = link.read(min(4096, size - len(data)))
+            if not chunk:
+                sys.exit("%s: %d of %d bytes received" % (port, len(data), size))
+            data += chunk
+        time.sleep(0.2)
+        link.baudrate = 115200
+    return data
+
+
+def write_csv(out, fixes):
+    out.write("utc,latitude,longitude,altitude,speed\n")
+    for utc, lat, lng, altitude, speed in fixes:
+        stamp = time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime(utc))
+        out.write("%s,%.5f,%.5f,%d,%d\n" % (stamp, lat / 1e5, lng / 1e5, altitude, speed))
+
+
+def write_gpx(out, fixes):
+    out.write('<?xml version="1.0" encoding="UTF-8"?>\n<gpx version="1.1" creator="LoRa APRS Beacon">\n<trk><trkseg>\n')
+    for utc, lat, lng, altitude, _ in fixes:
+        stamp = time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime(utc))
+        out.write('<trkpt lat="%.5f" lon="%.5f"><ele>%d</ele><time>%s</time></trkpt>\n' % (lat / 1e5, lng / 1e5, altitude, stamp))
+    out.write("</trkseg></trk>\n</gpx>\n")
+
+
+def self_test():
+    fixes = []
+    utc, lat, lng, altitude = 1700000000, 4512345, -123456, 120
+    for i in range(500):
+        utc += 1 if i % 50 else 4000
+        lat += 20 * (i % 7) - 50
+        lng += 30 if i != 300 else 50000  # a jump that starts a page
+        altitude += (i % 5) - 2
+        fixes.append((utc, lat, lng, altitude, i % 120))
+    data = encode(fixes)
+    assert len(data) % PAGE_SIZE == 0
+    assert decode(data) == (fixes, 0)
+    # a page cut short by a power loss is padded, the next one goes on
+    torn = data[: 3 * PAGE_SIZE] + data[3 * PAGE_SIZE : 3 * PAGE_SIZE + 100] + bytes(PAGE_SIZE - 100) + data[3 * PAGE_SIZE :]
+    decoded, bad = decode(torn)
+    assert bad == 1 and decoded == fixes, bad
+    # the page being filled is exported after the files with its sequence
+    assert decode(data + data[-PAGE_SIZE:])[0] == fixes
+    print("self test passed, %d fixes in %d bytes" % (len(fixes), len(data)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="*", help="copies of track.old and track.log, in that order")
+    parser.add_argument("--port", help="serial port of the tracker to download from")
+    parser.add_argument("-o", "--output", help="file to write (default stdout)")
+    parser.add_argument("--gpx", action="store_true", help="write GPX instead of CSV")
+    parser.add_argument("--self-test", action="store_true", help="check the decoder against the encoder")
+    args = parser.parse_args()
+
+    if args.self_test:
+        self_test()
+        return
+    if args.port:
+        data = download(args.port)
+    elif args.files:
+        data = b""
+        for name in args.files:
+            with open(name, "rb") as f:
+                data += f.read()
+            # each file is whole pages once recovered
+            data += bytes(-len(data) % PAGE_SIZE)
+    else:
+        parser.error("a port or files are needed")
+    fixes, bad = decode(data)
+    out = open(args.output, "w") if args.output else sys.stdout
+    (write_gpx if args.gpx else write_csv)(out, fixes)
+    print("%d fixes, %d damaged pages" % (len(fixes), bad), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()